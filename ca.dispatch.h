@@ -0,0 +1,126 @@
+/************************************************************************/
+/* Runtime selection of the CA kernels by instruction set		*/
+/*									*/
+/* One binary for a mixed fleet: CA_DISPATCH_DEFINE() compiles a kernel	*/
+/* (any static inline function returning void) once for each of		*/
+/*									*/
+/*	scalar		the baseline target of the compiler flags	*/
+/*	bmi2		+ POPCNT, BMI1/BMI2 (andn, shlx/shrx, rorx)	*/
+/*	avx2		+ AVX2						*/
+/*	avx512		+ AVX-512F/VL					*/
+/*									*/
+/* and defines an entry point of the same signature that calls the best	*/
+/* variant for the CPU.  The kernel is inlined into each variant, so	*/
+/* the compiler is free to use the instructions of that variant		*/
+/* throughout; where it cannot do much with them (the lattice step	*/
+/* carries across registers, which the vectorizer does not see through)	*/
+/* CA_DISPATCH_VARIANTS() takes a hand written kernel per variant	*/
+/* instead.  The choice is made once, before main(), with		*/
+/* __builtin_cpu_supports(), and may be overridden for benchmarking by	*/
+/* setting the environment variable CA_KERNEL to one of the names above	*/
+/* (a kernel the CPU lacks falls back to the best one, with a warning).	*/
+/* ca_kernel_name() reports the kernel in use.  Elsewhere than x86	*/
+/* every variant is the scalar one.					*/
+/************************************************************************/
+
+#ifndef CA_DISPATCH_H
+#define CA_DISPATCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CA_KERNEL_SCALAR	0
+#define CA_KERNEL_BMI2		1
+#define CA_KERNEL_AVX2		2
+#define CA_KERNEL_AVX512	3
+#define CA_KERNELS		4
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CA_TARGET_SCALAR
+#define CA_TARGET_BMI2		__attribute__((target("popcnt,bmi,bmi2")))
+#define CA_TARGET_AVX2		__attribute__((target("popcnt,bmi,bmi2,avx2")))
+#define CA_TARGET_AVX512	__attribute__((target("popcnt,bmi,bmi2,avx2,avx512f,avx512vl")))
+#else
+#define CA_TARGET_SCALAR
+#define CA_TARGET_BMI2
+#define CA_TARGET_AVX2
+#define CA_TARGET_AVX512
+#endif /* __x86_64__ */
+
+static const char *ca_kernel_names[CA_KERNELS] = { "scalar", "bmi2", "avx2", "avx512" };
+
+/* the kernel in use, set before main() */
+static int ca_kernel = CA_KERNEL_SCALAR;
+
+/* the best kernel this CPU runs */
+static inline int ca_kernel_best(void) {
+
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if(!__builtin_cpu_supports("popcnt"))
+		return(CA_KERNEL_SCALAR);
+	if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2"))
+		return(CA_KERNEL_AVX512);
+	if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2"))
+		return(CA_KERNEL_AVX2);
+	if(__builtin_cpu_supports("bmi2"))
+		return(CA_KERNEL_BMI2);
+#endif /* __x86_64__ */
+
+	return(CA_KERNEL_SCALAR);
+
+}
+
+/* pick the kernel once at startup, honouring CA_KERNEL if the CPU has it */
+static void __attribute__((constructor)) ca_kernel_select(void) {
+
+	char *name = getenv("CA_KERNEL");
+	int best = ca_kernel_best(), i;
+
+	ca_kernel = best;
+	if(!name || !*name)
+		return;
+
+	for(i = 0; i < CA_KERNELS; i++)
+		if(!strcmp(name, ca_kernel_names[i]))
+			break;
+
+	if(i == CA_KERNELS)
+		fprintf(stderr, "CA_KERNEL=%s is not a kernel, using %s\n", name, ca_kernel_names[best]);
+	else if(i > best)
+		fprintf(stderr, "CA_KERNEL=%s is not supported by this CPU, using %s\n", name, ca_kernel_names[best]);
+	else
+		ca_kernel = i;
+
+}
+
+static inline const char *ca_kernel_name(void) {
+
+	return(ca_kernel_names[ca_kernel]);
+
+}
+
+/* a variant of kernel per instruction set and the entry point name calling the one in use -	*/
+/* params is the parenthesized parameter list of kernel and args the matching argument list	*/
+#define CA_DISPATCH_DEFINE(name, kernel, params, args)							\
+	CA_DISPATCH_VARIANTS(name, kernel, kernel, kernel, kernel, params, args)
+
+/* as above with a kernel of its own for each instruction set, e.g. hand vectorized ones -	*/
+/* the kernels must be compiled for (at most) the instruction set of their variant		*/
+#define CA_DISPATCH_VARIANTS(name, scalar, bmi2, avx2, avx512, params, args)				\
+														\
+static inline CA_TARGET_SCALAR void name##_scalar params { scalar args; }				\
+static inline CA_TARGET_BMI2 void name##_bmi2 params { bmi2 args; }					\
+static inline CA_TARGET_AVX2 void name##_avx2 params { avx2 args; }					\
+static inline CA_TARGET_AVX512 void name##_avx512 params { avx512 args; }				\
+														\
+static inline void name params {										\
+														\
+	static void (*const variant[CA_KERNELS]) params = { name##_scalar, name##_bmi2, name##_avx2, name##_avx512 };	\
+														\
+	variant[ca_kernel] args;										\
+														\
+}
+
+#endif /* CA_DISPATCH_H */
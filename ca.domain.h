@@ -0,0 +1,249 @@
+/************************************************************************/
+/* Domain decomposition of very wide lattices over threads		*/
+/*									*/
+/* For research runs on 10^8 cells and up, far past what stays in	*/
+/* registers: the circular lattice is cut into one contiguous chunk of	*/
+/* registers per thread, and every thread steps its own chunk with the	*/
+/* word-parallel rule of ca.h.  A generation of a chunk needs only the	*/
+/* current generation of the chunk itself plus one register from each	*/
+/* neighbour (the halo), so the threads never meet at a barrier: each	*/
+/* publishes the number of generations it has completed in a counter on	*/
+/* a cache line of its own, and before stepping generation g to g + 1	*/
+/* it waits only until both of its neighbours have completed g.  That	*/
+/* one condition covers both directions of the exchange - the		*/
+/* neighbours' halo registers of generation g are written, and the	*/
+/* neighbours have finished reading the generation g - 1 registers of	*/
+/* this chunk that the step is about to overwrite (each chunk is double	*/
+/* buffered, generation g in buffer g % 2).  Neighbours thus never	*/
+/* drift more than one generation apart, while threads further away	*/
+/* run free.								*/
+/*									*/
+/*	ca_domain_start()	cut a lattice into chunks and start the	*/
+/*				threads					*/
+/*	ca_domain_advance()	step every chunk n generations, waiting	*/
+/*	ca_domain_read()	copy the lattice back out		*/
+/*	ca_domain_stop()	stop and join the threads		*/
+/*									*/
+/* Each thread allocates and first writes its own chunk, so on a NUMA	*/
+/* machine the chunk lands on the node the thread runs on; the only	*/
+/* traffic between threads is two registers and two counters per	*/
+/* generation.  Between calls to ca_domain_advance() the threads wait	*/
+/* with sched_yield().  The lattice must have at least as many		*/
+/* registers as there are threads.  Link with -pthread.			*/
+/************************************************************************/
+
+#ifndef CA_DOMAIN_H
+#define CA_DOMAIN_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#include "ca.h"
+#include "ca.dispatch.h"
+
+#define DOMAIN_LINE	64		/* cache line */
+#define DOMAIN_RULE30	30		/* folded at compile time */
+
+/* one thread's share of the lattice */
+struct ca_domain_chunk {
+
+	_Atomic uint64_t done __attribute__((aligned(DOMAIN_LINE)));	/* generations completed - written by the owner */
+	unsigned long int *buf[2];		/* generation g in buf[g % 2], registers 1 to regs, halos 0 and regs + 1 */
+	long int first, regs;			/* the registers of the lattice held */
+	struct ca_domain *domain;
+	pthread_t thread;
+
+} __attribute__((aligned(DOMAIN_LINE)));
+
+struct ca_domain {
+
+	int threads;
+	int created;				/* threads created - threads is fixed once they run */
+	unsigned long int rule;
+	const unsigned long int *initial;	/* the lattice to copy in at start */
+	_Atomic uint64_t target __attribute__((aligned(DOMAIN_LINE)));	/* generations asked for */
+	atomic_int started, failed, stop;
+	struct ca_domain_chunk *chunk;
+
+};
+
+/* a chunk of regs registers from reg into next, with the halo registers at reg - 1 and	*/
+/* reg + regs - the plain loop of ca_step() without the wrap around			*/
+static inline __attribute__((always_inline)) void ca_domain_kernel(const unsigned long int *reg, unsigned long int *next, long int regs, unsigned long int rule) {
+
+	long int i;
+
+	for(i = 0; i < regs; i++)
+		*(next + i) = CA_RULE(rule, CA_LEFT_OF(*(reg + i), *(reg + i - 1), CA_WORD_BITS),
+				      *(reg + i), CA_RIGHT_OF(*(reg + i), *(reg + i + 1), CA_WORD_BITS));
+
+}
+
+static inline void ca_domain_step(const unsigned long int *reg, unsigned long int *next, long int regs, unsigned long int rule) {
+
+	if(rule == DOMAIN_RULE30)
+		ca_domain_kernel(reg, next, regs, DOMAIN_RULE30);
+	else
+		ca_domain_kernel(reg, next, regs, rule);
+
+}
+CA_DISPATCH_DEFINE(ca_domain_step_dispatch, ca_domain_step,
+		   (const unsigned long int *reg, unsigned long int *next, long int regs, unsigned long int rule), (reg, next, regs, rule))
+
+/* wait for a counter to reach at least n */
+static inline void ca_domain_wait(_Atomic uint64_t *counter, uint64_t n) {
+
+	while(atomic_load_explicit(counter, memory_order_acquire) < n)
+		sched_yield();
+
+}
+
+/* a thread: set up its chunk, then step it whenever the target is ahead of it */
+static void *ca_domain_work(void *arg) {
+
+	struct ca_domain_chunk *self = (struct ca_domain_chunk *)arg, *left, *right;
+	struct ca_domain *domain = self->domain;
+	unsigned long int *cur;
+	uint64_t g = 0;
+	int i = self - domain->chunk;
+
+	left = domain->chunk + (i + domain->threads - 1) % domain->threads;
+	right = domain->chunk + (i + 1) % domain->threads;
+
+	/* first touch by the owner */
+	if(posix_memalign((void **)&self->buf[0], DOMAIN_LINE, (self->regs + 2)*sizeof(unsigned long int)) ||
+	   posix_memalign((void **)&self->buf[1], DOMAIN_LINE, (self->regs + 2)*sizeof(unsigned long int))) {
+		atomic_store_explicit(&domain->failed, 1, memory_order_relaxed);
+		atomic_fetch_add_explicit(&domain->started, 1, memory_order_release);
+		return(NULL);
+	}
+	memcpy(self->buf[0] + 1, domain->initial + self->first, self->regs*sizeof(unsigned long int));
+	memset(self->buf[1], 0, (self->regs + 2)*sizeof(unsigned long int));
+	atomic_fetch_add_explicit(&domain->started, 1, memory_order_release);
+
+	for(;;) {
+
+		/* nothing to do - wait for more generations or the stop */
+		while(g == atomic_load_explicit(&domain->target, memory_order_acquire)) {
+			if(atomic_load_explicit(&domain->stop, memory_order_relaxed))
+				return(NULL);
+			sched_yield();
+		}
+
+		/* the neighbours have completed generation g */
+		ca_domain_wait(&left->done, g);
+		ca_domain_wait(&right->done, g);
+
+		/* fetch the halos and step */
+		cur = self->buf[g & 1];
+		*cur = *(left->buf[g & 1] + left->regs);
+		*(cur + self->regs + 1) = *(right->buf[g & 1] + 1);
+		ca_domain_step_dispatch(cur + 1, self->buf[(g + 1) & 1] + 1, self->regs, domain->rule);
+
+		atomic_store_explicit(&self->done, ++g, memory_order_release);
+
+	}
+
+}
+
+/* stop and join the threads, freeing the chunks */
+static inline void ca_domain_stop(struct ca_domain *domain) {
+
+	int i;
+
+	atomic_store_explicit(&domain->stop, 1, memory_order_relaxed);
+	for(i = 0; i < domain->created; i++)
+		pthread_join(domain->chunk[i].thread, NULL);
+
+	for(i = 0; i < domain->threads; i++) {
+		free(domain->chunk[i].buf[0]);
+		free(domain->chunk[i].buf[1]);
+	}
+	free(domain->chunk);
+	domain->chunk = NULL;
+	domain->threads = 0;
+	domain->created = 0;
+
+}
+
+/* cut the lattice of regs registers into a chunk per thread, as even as can be, and start	*/
+/* the threads - reg is copied and may be reused on return, which is -1 on failure		*/
+static inline int ca_domain_start(struct ca_domain *domain, int threads, const unsigned long int *reg, long int regs, unsigned long int rule) {
+
+	long int first = 0;
+	int i;
+
+	if((threads < 1) || (threads > regs))
+		return(-1);
+
+	domain->threads = threads;
+	domain->created = 0;
+	domain->rule = rule;
+	domain->initial = reg;
+	atomic_init(&domain->target, 0);
+	atomic_init(&domain->started, 0);
+	atomic_init(&domain->failed, 0);
+	atomic_init(&domain->stop, 0);
+	if(posix_memalign((void **)&domain->chunk, DOMAIN_LINE, threads*sizeof(struct ca_domain_chunk)))
+		return(-1);
+	memset(domain->chunk, 0, threads*sizeof(struct ca_domain_chunk));
+
+	for(i = 0; i < threads; i++) {
+		atomic_init(&domain->chunk[i].done, 0);
+		domain->chunk[i].first = first;
+		domain->chunk[i].regs = regs/threads + (i < regs % threads);
+		domain->chunk[i].domain = domain;
+		first += domain->chunk[i].regs;
+	}
+
+	/* the running threads read threads for their neighbours, so a failure only counts them */
+	for(i = 0; i < threads; i++) {
+		if(pthread_create(&domain->chunk[i].thread, NULL, ca_domain_work, domain->chunk + i)) {
+			atomic_store_explicit(&domain->failed, 1, memory_order_relaxed);
+			break;
+		}
+		domain->created++;
+	}
+
+	/* the initial lattice is copied in before anyone steps, or is freed */
+	while(atomic_load_explicit(&domain->started, memory_order_acquire) < domain->created)
+		sched_yield();
+
+	if(atomic_load_explicit(&domain->failed, memory_order_relaxed)) {
+		ca_domain_stop(domain);
+		return(-1);
+	}
+
+	domain->initial = NULL;
+	return(0);
+
+}
+
+/* step the whole lattice generations further, returning once every chunk is there */
+static inline void ca_domain_advance(struct ca_domain *domain, uint64_t generations) {
+
+	uint64_t target = atomic_load_explicit(&domain->target, memory_order_relaxed) + generations;
+	int i;
+
+	atomic_store_explicit(&domain->target, target, memory_order_release);
+	for(i = 0; i < domain->threads; i++)
+		ca_domain_wait(&domain->chunk[i].done, target);
+
+}
+
+/* the current generation of the lattice into reg - only between calls to ca_domain_advance() */
+static inline void ca_domain_read(const struct ca_domain *domain, unsigned long int *reg) {
+
+	uint64_t g = atomic_load_explicit(&domain->target, memory_order_relaxed);
+	int i;
+
+	for(i = 0; i < domain->threads; i++)
+		memcpy(reg + domain->chunk[i].first, domain->chunk[i].buf[g & 1] + 1, domain->chunk[i].regs*sizeof(unsigned long int));
+
+}
+
+#endif /* CA_DOMAIN_H */
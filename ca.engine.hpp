@@ -0,0 +1,192 @@
+/************************************************************************/
+/* C++ engine for elementary cellular automata generators		*/
+/*									*/
+/* ca_engine<Rule, Width, Taps> is a header-only random bit engine on	*/
+/* the word-parallel kernel of ca.h that satisfies			*/
+/* std::uniform_random_bit_generator, so it drops straight into		*/
+/* std::shuffle, the <random> distributions and templated samplers:	*/
+/*									*/
+/*	ca_engine<30, 448, 7> engine(seed);				*/
+/*	std::normal_distribution<double> normal;			*/
+/*	double x = normal(engine);					*/
+/*									*/
+/* The rule is a template parameter, so the select tree of CA_RULE is	*/
+/* folded at compile time into the minimal formula for that rule and	*/
+/* each rule gets a specialised kernel, as does each lattice width	*/
+/* (Width cells, a multiple of 64, stepped a whole register at a time).	*/
+/* Taps cells are read per generation - the center cell of Taps		*/
+/* registers spread evenly around the lattice, starting from the middle	*/
+/* register - and packed first generation first into 64-bit words.	*/
+/* Words are produced CA_ENGINE_BUFFER at a time into an internal	*/
+/* buffer, so operator() is usually just a load.			*/
+/*									*/
+/* The engine matches the C generator bit for bit.  Seeded from s with	*/
+/* the splitmix64 seeding of rule30_rng_init_full(), one tap gives the	*/
+/* words of rule30_rng_fill_u64() and one tap per register (7 for 448	*/
+/* cells) those of rule30_rng_fill_u64_taps() with the default tap set.	*/
+/*									*/
+/* Requires C++17; under C++20 the concept is checked at compile time.	*/
+/************************************************************************/
+
+#ifndef CA_ENGINE_HPP
+#define CA_ENGINE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#if __cplusplus >= 202002L
+#include <random>
+#endif /* C++20 */
+
+#include "ca.h"
+
+#ifndef CA_ENGINE_BUFFER
+#define CA_ENGINE_BUFFER	64		/* words produced per refill */
+#endif
+#define CA_ENGINE_CENTER	32		/* the tapped cell of a register, as CENTER_MASK */
+#define CA_ENGINE_SEED		1234523
+
+template<unsigned Rule = 30, std::size_t Width = 448, std::size_t Taps = 1>
+class ca_engine {
+
+public:
+
+	typedef std::uint64_t result_type;
+
+	static constexpr std::size_t regs = Width / 64;
+
+	static_assert(Rule < 256, "elementary rules are numbered 0 to 255");
+	static_assert(Width && !(Width % 64), "the lattice is a whole number of 64-bit registers");
+	static_assert(Taps && (Taps <= regs), "between one tap and one tap per register");
+
+	static constexpr result_type min() { return(0); }
+	static constexpr result_type max() { return(std::numeric_limits<result_type>::max()); }
+
+	explicit ca_engine(result_type s = CA_ENGINE_SEED) { seed(s); }
+
+	/* fill the whole lattice from s, splitmix64 as rule30_rng_init_full() */
+	void seed(result_type s = CA_ENGINE_SEED) {
+
+		result_type z = s, x;
+
+		for(std::size_t i = 0; i < regs; i++) {
+			z += 0x9E3779B97F4A7C15ULL;
+			x = z;
+			x = (x ^ (x >> 30))*0xBF58476D1CE4E5B9ULL;
+			x = (x ^ (x >> 27))*0x94D049BB133111EBULL;
+			lattice[i] = x ^ (x >> 31);
+		}
+		accumulator = 0;
+		space = 64;
+		next = CA_ENGINE_BUFFER;
+
+	}
+
+	result_type operator()() {
+
+		if(next == CA_ENGINE_BUFFER)
+			refill();
+
+		return(buffer[next++]);
+
+	}
+
+	void discard(unsigned long long n) {
+
+		for(; n; n--)
+			(*this)();
+
+	}
+
+	friend bool operator==(const ca_engine &a, const ca_engine &b) {
+
+		return((a.lattice == b.lattice) && (a.accumulator == b.accumulator) && (a.space == b.space) &&
+		       (a.buffer == b.buffer) && (a.next == b.next));
+
+	}
+
+	friend bool operator!=(const ca_engine &a, const ca_engine &b) { return(!(a == b)); }
+
+private:
+
+	/* which registers are tapped - Taps of them spaced evenly from the middle one */
+	static constexpr std::array<bool, regs> tapped() {
+
+		std::array<bool, regs> tap = { };
+
+		for(std::size_t k = 0; k < Taps; k++)
+			tap[(regs / 2 + k*(regs / Taps)) % regs] = true;
+
+		return(tap);
+
+	}
+
+	static constexpr std::array<bool, regs> tap = tapped();
+
+	/* one generation - Rule is a constant so CA_RULE folds to the minimal formula */
+	inline __attribute__((always_inline)) void step() {
+
+		std::array<result_type, regs> stepped;
+
+#pragma GCC unroll 64
+		for(std::size_t i = 0; i < regs; i++)
+			stepped[i] = CA_RULE((result_type)Rule, CA_LEFT_OF(lattice[i], lattice[(i + regs - 1) % regs], 64),
+					     lattice[i], CA_RIGHT_OF(lattice[i], lattice[(i + 1) % regs], 64));
+		lattice = stepped;
+
+	}
+
+	/* the tapped cells of this generation, lowest register first in the highest bit */
+	inline __attribute__((always_inline)) result_type harvest() const {
+
+		result_type bits = 0;
+
+#pragma GCC unroll 64
+		for(std::size_t i = 0; i < regs; i++)
+			if(tap[i])
+				bits = (bits << 1) | ((lattice[i] >> CA_ENGINE_CENTER) & 1);
+
+		return(bits);
+
+	}
+
+	/* the next CA_ENGINE_BUFFER words - bits that do not fit carry over to the next refill */
+	void refill() {
+
+		result_type bits;
+		std::size_t i = 0;
+
+		while(i < CA_ENGINE_BUFFER) {
+
+			step();
+			bits = harvest();
+
+			if((int)Taps < space) {
+				accumulator = (accumulator << Taps) | bits;
+				space -= Taps;
+			}
+			else {
+				buffer[i++] = (space < 64 ? accumulator << space : 0) | (bits >> (Taps - space));
+				accumulator = bits;
+				space = 64 - (Taps - space);
+			}
+
+		}
+		next = 0;
+
+	}
+
+	std::array<result_type, regs> lattice;
+	std::array<result_type, CA_ENGINE_BUFFER> buffer = { };
+	result_type accumulator;	/* bits harvested but not yet in a word */
+	int space;			/* bits still free in accumulator */
+	std::size_t next;		/* the next word of buffer to hand out */
+
+};
+
+#if __cplusplus >= 202002L
+static_assert(std::uniform_random_bit_generator<ca_engine<>>);
+#endif /* C++20 */
+
+#endif /* CA_ENGINE_HPP */
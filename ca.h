@@ -0,0 +1,88 @@
+/************************************************************************/
+/* Word-parallel elementary cellular automata				*/
+/*									*/
+/* The stepping kernel shared by the utilities.  A lattice is a		*/
+/* circular array of registers, left to right, each holding WORDSIZE	*/
+/* cells with the left-most cell in the most significant bit.  A	*/
+/* generation imposes the rule on a whole register at a time: the left	*/
+/* and right neighbours of all cells are formed by shifting the		*/
+/* register one bit, carrying in the edge cell of the adjacent register	*/
+/* (wrapping around at the ends of the array), and the rule number is	*/
+/* expanded into a tree of selects on (left, middle, right).  With the	*/
+/* rule fixed at compile time the compiler folds this down to the	*/
+/* minimal boolean formula, e.g. (left XOR (middle OR right)) for rule	*/
+/* 30, so the generality costs nothing.					*/
+/*									*/
+/* The width of a lattice is a compile-time parameter:			*/
+/*									*/
+/*	CA_LATTICE_DEFINE(name, word type, registers, bits per word)	*/
+/*									*/
+/* defines the lattice type "name" and its step function name_step(),	*/
+/* the C equivalent of a Lattice<NWords> template.  The register count	*/
+/* is a constant, so the step is unrolled at compile time and small	*/
+/* lattices stay entirely in registers.  Any type with the bitwise	*/
+/* operators works as a word, including GCC vector types for SIMD.	*/
+/* Lattices whose width is only known at run time, or too wide to be	*/
+/* held in registers, are stepped by ca_step() from one register array	*/
+/* into a second one.							*/
+/************************************************************************/
+
+#ifndef CA_H
+#define CA_H
+
+#define CA_WORD_BITS	(8*(int)sizeof(unsigned long int))
+
+/* the rule number expanded into a tree of bitwise selects on the (left, middle, right)	*/
+/* neighbourhood - with a constant rule the all-ones/all-zeros leaves fold away and the	*/
+/* compiler is left with the minimal boolean formula for the rule				*/
+#define CA_SELECT(s, a, b)	(((s) & (a)) | (~(s) & (b)))
+#define CA_RULE_BIT(rule, n)	(-(((rule) >> (n)) & 1UL))
+#define CA_RULE(rule, l, m, r)	CA_SELECT(l, CA_SELECT(m, CA_SELECT(r, CA_RULE_BIT(rule, 7), CA_RULE_BIT(rule, 6)), CA_SELECT(r, CA_RULE_BIT(rule, 5), CA_RULE_BIT(rule, 4))), \
+					     CA_SELECT(m, CA_SELECT(r, CA_RULE_BIT(rule, 3), CA_RULE_BIT(rule, 2)), CA_SELECT(r, CA_RULE_BIT(rule, 1), CA_RULE_BIT(rule, 0))))
+
+/* neighbours of every cell in a register - the edge cell is carried in from the adjacent register */
+#define CA_LEFT_OF(reg, prev_reg, bits)		(((reg) >> 1) | ((prev_reg) << ((bits) - 1)))
+#define CA_RIGHT_OF(reg, next_reg, bits)	(((reg) << 1) | ((next_reg) >> ((bits) - 1)))
+
+/* a circular lattice of a fixed number of registers and its step function */
+#define CA_LATTICE_DEFINE(name, word_t, regs, bits)								\
+														\
+typedef struct {												\
+														\
+	word_t reg[regs];			/* the circular register array, left to right */		\
+														\
+} name;														\
+														\
+/* impose the rule on every cell of the lattice at once, wrapping the array ends */				\
+static inline __attribute__((always_inline)) void name##_step(name *lattice, unsigned long int rule) {		\
+														\
+	name next;												\
+	int i;													\
+														\
+	_Pragma("GCC unroll 64")										\
+	for(i = 0; i < (regs); i++)										\
+		next.reg[i] = CA_RULE(rule, CA_LEFT_OF(lattice->reg[i], lattice->reg[(i + (regs) - 1) % (regs)], bits),	\
+				      lattice->reg[i], CA_RIGHT_OF(lattice->reg[i], lattice->reg[(i + 1) % (regs)], bits));	\
+	*lattice = next;											\
+														\
+}
+
+/* a lattice of any number of unsigned long registers, known only at run time, from reg	*/
+/* into next (which must not overlap it) - the ends wrap around and the registers between	*/
+/* them are a plain loop the compiler can vectorize						*/
+static inline __attribute__((always_inline)) void ca_step(const unsigned long int *reg, unsigned long int *next, long int regs, unsigned long int rule) {
+
+	long int i;
+
+	*next = CA_RULE(rule, CA_LEFT_OF(*reg, *(reg + regs - 1), CA_WORD_BITS),
+			*reg, CA_RIGHT_OF(*reg, *(reg + (regs > 1)), CA_WORD_BITS));
+	for(i = 1; i < regs - 1; i++)
+		*(next + i) = CA_RULE(rule, CA_LEFT_OF(*(reg + i), *(reg + i - 1), CA_WORD_BITS),
+				      *(reg + i), CA_RIGHT_OF(*(reg + i), *(reg + i + 1), CA_WORD_BITS));
+	if(regs > 1)
+		*(next + regs - 1) = CA_RULE(rule, CA_LEFT_OF(*(reg + regs - 1), *(reg + regs - 2), CA_WORD_BITS),
+					     *(reg + regs - 1), CA_RIGHT_OF(*(reg + regs - 1), *reg, CA_WORD_BITS));
+
+}
+
+#endif /* CA_H */
@@ -0,0 +1,106 @@
+/************************************************************************/
+/* Jump-ahead for the additive (linear) rules				*/
+/*									*/
+/* For the rules whose new cell is an XOR of some of its neighbours -	*/
+/* rule 90 (left XOR right), rule 150 (left XOR middle XOR right) and	*/
+/* the trivial 60, 102, 170, 204, 240 - a generation on the cyclic	*/
+/* lattice of N cells is multiplication of the lattice, read as a	*/
+/* polynomial s(t) over GF(2), by					*/
+/*									*/
+/*		p(t) = c_l t^-1 + c_m + c_r t		modulo t^N - 1	*/
+/*									*/
+/* and n generations are multiplication by p(t)^n.  Over GF(2) squaring	*/
+/* is the Frobenius map, so						*/
+/*									*/
+/*		p(t)^(2^k) = c_l t^-(2^k) + c_m + c_r t^(2^k)		*/
+/*									*/
+/* without any polynomial products at all: stepping 2^k generations is	*/
+/* two rotations of the lattice by 2^k cells and an XOR.  Writing n in	*/
+/* binary, ca_jump() advances any number of generations with at most 64	*/
+/* such steps, O(registers * log n) work in place of O(registers * n),	*/
+/* which is what is needed to split one stream into non-overlapping	*/
+/* substreams (substream j starting at generation j*2^40, say).		*/
+/*									*/
+/* Since every power of p(t) reduces to three terms no carry-less	*/
+/* multiply (PCLMUL) is needed.  The lattice is the same circular	*/
+/* register array, left-most cell in the most significant bit, as the	*/
+/* lattices of ca.h, and any register count may be used.		*/
+/************************************************************************/
+
+#ifndef CA_JUMP_H
+#define CA_JUMP_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ca.h"
+
+/* rotate the whole lattice left (towards register 0) by cells, out and in must not overlap */
+static inline void ca_rotate(unsigned long int *out, const unsigned long int *in, int regs, uint64_t cells) {
+
+	uint64_t shift = cells % ((uint64_t)regs*CA_WORD_BITS);
+	int words = shift / CA_WORD_BITS, bits = shift % CA_WORD_BITS;
+	int i;
+
+	for(i = 0; i < regs; i++) {
+		if(bits)
+			*(out + i) = (*(in + (i + words) % regs) << bits) | (*(in + (i + words + 1) % regs) >> (CA_WORD_BITS - bits));
+		else
+			*(out + i) = *(in + (i + words) % regs);
+	}
+
+}
+
+/* the (left, middle, right) coefficients of a linear rule, -1 if the rule is not linear */
+static inline int ca_linear_rule(unsigned long int rule, int *left, int *middle, int *right) {
+
+	*left = (rule >> 4) & 1;	/* 100 */
+	*middle = (rule >> 2) & 1;	/* 010 */
+	*right = (rule >> 1) & 1;	/* 001 */
+
+	if(rule != ((*left ? 0xF0UL : 0) ^ (*middle ? 0xCCUL : 0) ^ (*right ? 0xAAUL : 0)))
+		return(-1);
+
+	return(0);
+
+}
+
+/* advance a lattice of regs registers by generations under a linear rule, in place	*/
+/* returns -1 (leaving the lattice untouched) if the rule is not linear			*/
+static inline int ca_jump(unsigned long int *reg, int regs, unsigned long int rule, uint64_t generations) {
+
+	unsigned long int *left_reg, *right_reg;
+	uint64_t cells = (uint64_t)regs*CA_WORD_BITS;
+	uint64_t stride = 1 % cells;	/* 2^k modulo the lattice size */
+	int left, middle, right;
+	int i;
+
+	if(ca_linear_rule(rule, &left, &middle, &right) || (regs < 1))
+		return(-1);
+
+	left_reg = (unsigned long int *)malloc(2*regs*sizeof(unsigned long int));
+	if(!left_reg)
+		return(-1);
+	right_reg = left_reg + regs;
+
+	for(; generations; generations >>= 1) {
+
+		/* 2^k generations: the left neighbour 2^k cells away XOR the middle XOR the right one */
+		if(generations & 1) {
+			ca_rotate(left_reg, reg, regs, cells - stride);
+			ca_rotate(right_reg, reg, regs, stride);
+			for(i = 0; i < regs; i++)
+				*(reg + i) = (left ? *(left_reg + i) : 0) ^ (middle ? *(reg + i) : 0) ^ (right ? *(right_reg + i) : 0);
+		}
+
+		stride = (2*stride) % cells;
+
+	}
+
+	free(left_reg);
+	return(0);
+
+}
+
+#endif /* CA_JUMP_H */
@@ -0,0 +1,274 @@
+/************************************************************************/
+/* Hot-path counters for the CA engines					*/
+/*									*/
+/* Compiled in only with -DCA_STATS; otherwise every macro below is	*/
+/* empty and the engines are exactly as before.  With it, the		*/
+/* generator, the display kernel of rule30.c and the cipher count	*/
+/*									*/
+/*	calls, generations stepped and bits harvested per engine	*/
+/*	the sizes of bulk batches, as a histogram of powers of two	*/
+/*	reseeds, key schedules and blocks encrypted and decrypted	*/
+/*	cycles spent in each (TSC ticks on x86, nanoseconds elsewhere)	*/
+/*									*/
+/* into counters of the calling thread, so the hot path only ever adds	*/
+/* to memory of its own - no atomic read-modify-write and no shared	*/
+/* cache lines.  Each thread's counters are allocated on its first	*/
+/* count and pushed onto a lock-free list, which is never shortened	*/
+/* (the counts of threads that have exited are kept), so		*/
+/*									*/
+/*	ca_stats_snapshot()		sums every thread's counters	*/
+/*	ca_stats_print()		writes a snapshot to an fd	*/
+/*	ca_stats_install(sig)		prints the totals on signal sig	*/
+/*					(e.g. SIGUSR1) and at exit	*/
+/*									*/
+/* may read them at any time from any thread, or from the signal	*/
+/* handler, which formats with write() alone.				*/
+/************************************************************************/
+
+#ifndef CA_STATS_H
+#define CA_STATS_H
+
+#ifdef CA_STATS
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif /* __x86_64__ */
+
+/* the phases counted */
+#define CA_PHASE_RNG		0		/* the generator's calls */
+#define CA_PHASE_CA		1		/* generations of rule30.c */
+#define CA_PHASE_SCHEDULE	2		/* xr30256 key schedules */
+#define CA_PHASE_ENCRYPT	3		/* xr30256 blocks encrypted */
+#define CA_PHASE_DECRYPT	4		/* xr30256 blocks decrypted */
+#define CA_PHASES		5
+#define CA_STATS_BATCHES	32		/* batch histogram, 2^i to 2^(i+1) - 1 words */
+#define CA_STATS_LINE		64		/* cache line */
+
+struct ca_stats {
+
+	uint64_t calls[CA_PHASES];
+	uint64_t generations[CA_PHASES];
+	uint64_t bits[CA_PHASES];		/* random bits harvested */
+	uint64_t cycles[CA_PHASES];
+	uint64_t batch[CA_STATS_BATCHES];	/* bulk calls by words asked for */
+	uint64_t reseeds;
+
+};
+
+/* one thread's counters, on a line of their own */
+struct ca_stats_thread {
+
+	struct ca_stats stats;
+	struct ca_stats_thread *next;
+
+} __attribute__((aligned(CA_STATS_LINE)));
+
+static const char *ca_stats_phase_names[CA_PHASES] = { "rng", "ca", "key schedule", "encrypt", "decrypt" };
+
+static struct ca_stats_thread *ca_stats_threads = NULL;	/* every thread that has counted */
+static __thread struct ca_stats_thread *ca_stats_self = NULL;
+
+static inline uint64_t ca_stats_ticks(void) {
+
+#if defined(__x86_64__) || defined(__i386__)
+	return(__rdtsc());
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return((uint64_t)now.tv_sec*1000000000ULL + now.tv_nsec);
+#endif /* __x86_64__ */
+
+}
+
+/* the calling thread's counters, registered on first use */
+static inline struct ca_stats *ca_stats_local(void) {
+
+	struct ca_stats_thread *self = ca_stats_self;
+
+	if(__builtin_expect(!self, 0)) {
+		if(posix_memalign((void **)&self, CA_STATS_LINE, sizeof(struct ca_stats_thread)))
+			abort();
+		memset(self, 0, sizeof(struct ca_stats_thread));
+		self->next = __atomic_load_n(&ca_stats_threads, __ATOMIC_RELAXED);
+		while(!__atomic_compare_exchange_n(&ca_stats_threads, &self->next, self, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+		ca_stats_self = self;
+	}
+
+	return(&self->stats);
+
+}
+
+/* only the owning thread writes a counter, so a plain add suffices - the relaxed atomic	*/
+/* load and store (plain moves on x86) just keep the concurrent snapshots well defined	*/
+#define CA_STATS_BUMP(counter, n)	__atomic_store_n(&(counter), __atomic_load_n(&(counter), __ATOMIC_RELAXED) + (n), __ATOMIC_RELAXED)
+
+/* time a phase: CA_STATS_START(t) declares and starts t, CA_STATS_END() counts the call */
+#define CA_STATS_START(t)		uint64_t t = ca_stats_ticks()
+#define CA_STATS_END(phase, t, gens, nbits)	do {							\
+						struct ca_stats *ca_stats_mine = ca_stats_local();	\
+						CA_STATS_BUMP(ca_stats_mine->cycles[phase], ca_stats_ticks() - (t));	\
+						CA_STATS_BUMP(ca_stats_mine->calls[phase], 1);		\
+						CA_STATS_BUMP(ca_stats_mine->generations[phase], (gens));	\
+						CA_STATS_BUMP(ca_stats_mine->bits[phase], (nbits));	\
+					} while(0)
+#define CA_STATS_BATCH(words)		do {							\
+						uint64_t ca_stats_words = (words);			\
+						int ca_stats_bin = ca_stats_words ? 63 - __builtin_clzll(ca_stats_words) : 0;	\
+						CA_STATS_BUMP(ca_stats_local()->batch[ca_stats_bin < CA_STATS_BATCHES ? ca_stats_bin : CA_STATS_BATCHES - 1], 1);	\
+					} while(0)
+#define CA_STATS_RESEED()		CA_STATS_BUMP(ca_stats_local()->reseeds, 1)
+#define CA_STATS_INSTALL(sig)		ca_stats_install(sig)
+
+/* the sum of every thread's counters so far */
+static inline void ca_stats_snapshot(struct ca_stats *total) {
+
+	struct ca_stats_thread *thread;
+	uint64_t *sum = (uint64_t *)total, *count;
+	size_t i;
+
+	memset(total, 0, sizeof(struct ca_stats));
+	for(thread = __atomic_load_n(&ca_stats_threads, __ATOMIC_ACQUIRE); thread; thread = thread->next) {
+		count = (uint64_t *)&thread->stats;
+		for(i = 0; i < sizeof(struct ca_stats)/sizeof(uint64_t); i++)
+			*(sum + i) += __atomic_load_n(count + i, __ATOMIC_RELAXED);
+	}
+
+}
+
+/* append a string, or a number, to line in width columns - right aligned, or left aligned	*/
+/* for a negative width - with nothing that is not async-signal-safe			*/
+static inline void ca_stats_string(char *line, size_t *len, const char *s, int width) {
+
+	int n = strlen(s), pad = (width < 0 ? -width : width) - n;
+
+	for(; (width > 0) && (pad > 0); pad--)
+		*(line + (*len)++) = ' ';
+	while(*s)
+		*(line + (*len)++) = *s++;
+	for(; pad > 0; pad--)
+		*(line + (*len)++) = ' ';
+
+}
+
+static inline void ca_stats_number(char *line, size_t *len, uint64_t n, int width) {
+
+	char digits[24];
+	int i = sizeof(digits) - 1;
+
+	digits[i] = '\0';
+	do {
+		digits[--i] = '0' + n % 10;
+		n /= 10;
+	} while(n);
+
+	ca_stats_string(line, len, digits + i, width);
+
+}
+
+/* write a snapshot to fd as a table, with write() alone so that it is safe in a signal handler */
+static inline void ca_stats_print(int fd, const struct ca_stats *stats) {
+
+	char line[256];
+	size_t len;
+	int i;
+
+	len = 0;
+	ca_stats_string(line, &len, "# ca stats\n", 0);
+	ca_stats_string(line, &len, "phase", -12);
+	ca_stats_string(line, &len, "calls", 10);
+	ca_stats_string(line, &len, "generations", 20);
+	ca_stats_string(line, &len, "bits", 20);
+	ca_stats_string(line, &len, "cycles", 20);
+	ca_stats_string(line, &len, "cycles/gen", 12);
+	ca_stats_string(line, &len, "\n", 0);
+	if(write(fd, line, len) < 0)
+		return;
+
+	for(i = 0; i < CA_PHASES; i++) {
+		if(!stats->calls[i])
+			continue;
+		len = 0;
+		ca_stats_string(line, &len, ca_stats_phase_names[i], -12);
+		ca_stats_number(line, &len, stats->calls[i], 10);
+		ca_stats_number(line, &len, stats->generations[i], 20);
+		ca_stats_number(line, &len, stats->bits[i], 20);
+		ca_stats_number(line, &len, stats->cycles[i], 20);
+		ca_stats_number(line, &len, stats->generations[i] ? stats->cycles[i] / stats->generations[i] : 0, 12);
+		ca_stats_string(line, &len, "\n", 0);
+		if(write(fd, line, len) < 0)
+			return;
+	}
+
+	len = 0;
+	ca_stats_string(line, &len, "reseeds ", 0);
+	ca_stats_number(line, &len, stats->reseeds, 0);
+	ca_stats_string(line, &len, "\nbatches", 0);
+	for(i = 0; i < CA_STATS_BATCHES; i++) {
+		if(!stats->batch[i])
+			continue;
+		ca_stats_string(line, &len, " 2^", 0);
+		ca_stats_number(line, &len, i, 0);
+		ca_stats_string(line, &len, ":", 0);
+		ca_stats_number(line, &len, stats->batch[i], 0);
+		if(len > sizeof(line) - 64) {
+			if(write(fd, line, len) < 0)
+				return;
+			len = 0;
+		}
+	}
+	ca_stats_string(line, &len, "\n", 0);
+	if(write(fd, line, len) < 0)
+		return;
+
+}
+
+static void ca_stats_dump(void) {
+
+	struct ca_stats total;
+
+	ca_stats_snapshot(&total);
+	ca_stats_print(STDERR_FILENO, &total);
+
+}
+
+static void ca_stats_signal(int sig) {
+
+	(void)sig;
+	ca_stats_dump();
+
+}
+
+/* print the totals to stderr on signal sig (0 for none) and at exit */
+static inline void ca_stats_install(int sig) {
+
+	struct sigaction action;
+
+	if(sig) {
+		memset(&action, 0, sizeof(action));
+		action.sa_handler = ca_stats_signal;
+		action.sa_flags = SA_RESTART;
+		sigemptyset(&action.sa_mask);
+		sigaction(sig, &action, NULL);
+	}
+	atexit(ca_stats_dump);
+
+}
+
+#else
+
+#define CA_STATS_START(t)
+#define CA_STATS_END(phase, t, gens, nbits)
+#define CA_STATS_BATCH(words)
+#define CA_STATS_RESEED()
+#define CA_STATS_INSTALL(sig)
+
+#endif /* CA_STATS */
+
+#endif /* CA_STATS_H */
@@ -0,0 +1,627 @@
+/************************************************************************/
+/* Streaming statistical test battery for rule 30 output		*/
+/*									*/
+/* Tests any amount of raw 64-bit output as fast as it arrives, from	*/
+/* stdin (e.g. rule30rng -b 64) or from a built-in generator: the	*/
+/* center column, the default tap set of a fully seeded lattice or the	*/
+/* counter mode of rule30.ctr.h.  The stream is cut into chunks of	*/
+/* CHUNK_WORDS words, tested by a pool of threads into tallies of their	*/
+/* own that are summed at the end; only the transition between two	*/
+/* chunks is counted by the reader.  The bit counts use the popcount	*/
+/* kernel of the instruction set chosen at startup.			*/
+/*									*/
+/* The battery, on the words as one bitstream:				*/
+/*									*/
+/*	monobit		fraction of ones (NIST SP 800-22 2.1)		*/
+/*	runs		number of runs of equal bits (NIST 2.3)		*/
+/*	poker4		chi-square of the 4-bit blocks, 15 dof		*/
+/*	poker8		chi-square of the bytes, 255 dof		*/
+/*	serial		chi-square of the byte pairs, 65535 dof		*/
+/*	gap		gaps between bytes below 32			*/
+/*	birthday	spacings of 512 birthdays in 2^24 days		*/
+/*	linear		linear complexity, 1024-bit blocks (NIST 2.10)	*/
+/*									*/
+/* Each test prints its p-value, which should be uniform on (0, 1) for	*/
+/* a good generator - a p-value below 1e-4 is flagged, and a chi-square	*/
+/* with bins that expect fewer than 5 samples prints n/a.  -c takes k,	*/
+/* M, G and T suffixes, the built-in generators default to 256 MB and	*/
+/* -j to the number of CPUs online:					*/
+/*									*/
+/*	rule30battery [-j threads] [-c bytes] < stream			*/
+/*	rule30battery -g center|taps|counter [-c bytes] [-s seed]	*/
+/*									*/
+/* compile with:							*/
+/*	gcc -O3 -o rule30battery rule30.battery.c -lm -lpthread		*/
+/************************************************************************/
+
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "rule30.rng.h"
+#include "rule30.ctr.h"
+#include "rule30.battery.h"
+
+#define CHUNK_WORDS	(1 << 17)	/* 1 MB handed to a worker at a time */
+#define SUSPECT		1.0e-4		/* p-values below this are flagged */
+#define GAP_BINS	32		/* gaps 0..GAP_BINS-2, the last bin for longer ones */
+#define GAP_P		(1.0/8.0)	/* a byte below 32 */
+#define BDAY_DAYS	(1 << 24)	/* days in the birthday year */
+#define BDAY_COUNT	512		/* birthdays per sample, two per word */
+#define BDAY_BINS	7		/* duplicate spacings 0..5 and more */
+#define BDAY_LAMBDA	2.0		/* BDAY_COUNT^3/(4*BDAY_DAYS) */
+#define BDAY_SAMPLES	64		/* samples taken per chunk */
+#define LC_BITS		1024		/* linear complexity block length */
+#define LC_WORDS	(LC_BITS/64 + 2)
+#define LC_BLOCKS	16		/* blocks tested per chunk */
+#define LC_BINS		7
+#define GEN_BYTES	(256ULL << 20)	/* default length of the built-in generators */
+
+#define GEN_STDIN	0
+#define GEN_CENTER	1
+#define GEN_TAPS	2
+#define GEN_COUNTER	3
+
+/* what a worker counts - one per worker, summed at the end */
+struct tally {
+
+	uint64_t words;
+	uint64_t ones;
+	uint64_t transitions;
+	uint64_t hist[1 << 16];
+	uint64_t gap[GAP_BINS];
+	double gap_weight[GAP_BINS];
+	uint64_t bday[BDAY_BINS];
+	uint64_t lc[LC_BINS];
+
+};
+
+/* a buffer passed from the reader to the workers */
+struct chunk {
+
+	uint64_t *buf;
+	size_t words;
+	int busy;
+
+};
+
+/* the queue shared by the reader and the workers - chunk n is in slot n % depth */
+struct queue {
+
+	struct chunk *chunk;
+	int depth;
+	uint64_t filled;
+	uint64_t taken;
+	int done;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+
+};
+
+struct worker {
+
+	pthread_t thread;
+	struct queue *queue;
+	struct tally *tally;
+
+};
+
+/* p-value of a standard normal statistic, two-sided */
+double normal_p(double z) {
+
+	return(erfc(fabs(z)/sqrt(2.0)));
+
+}
+
+/* upper tail of a chi-square statistic, by the Wilson-Hilferty normal approximation */
+double chisq_p(double chisq, int dof) {
+
+	double z;
+
+	z = (pow(chisq/dof, 1.0/3.0) - (1.0 - 2.0/(9.0*dof)))/sqrt(2.0/(9.0*dof));
+	return(0.5*erfc(z/sqrt(2.0)));
+
+}
+
+/* the 16-bit histogram, of which the poker and serial tests are marginals */
+static inline void histogram(const uint64_t *buf, size_t n, uint64_t *hist) {
+
+	size_t i;
+
+	for(i = 0; i < n; i++) {
+		(*(hist + (*(buf + i) >> 48)))++;
+		(*(hist + ((*(buf + i) >> 32) & 0xFFFF)))++;
+		(*(hist + ((*(buf + i) >> 16) & 0xFFFF)))++;
+		(*(hist + (*(buf + i) & 0xFFFF)))++;
+	}
+
+}
+
+/* gaps between bytes below 32, eight bytes a word - a byte is below 32 when its top three	*/
+/* bits are clear, found for all bytes at once by the carry-free zero byte test.  Gaps	*/
+/* running off either end of buf are not counted, and the expected counts are weighted	*/
+/* to match: a gap of g can only be seen complete when it starts at least g + 1 bytes	*/
+/* before the end.									*/
+static inline void gaps(const uint64_t *buf, size_t n, struct tally *tally) {
+
+	size_t i;
+	long long int last = -1, byte, length = 8*n;
+	uint64_t top, marks;
+	double q = 1.0 - GAP_P, weight = GAP_P;
+	int g;
+
+	for(i = 0; i < n; i++) {
+		top = *(buf + i) & 0xE0E0E0E0E0E0E0E0ULL;
+		marks = ~(((top & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL) | top | 0x7F7F7F7F7F7F7F7FULL);
+		while(marks) {
+			byte = 8*i + (__builtin_clzll(marks) >> 3);
+			if(last >= 0)
+				tally->gap[(byte - last - 1 < GAP_BINS - 1) ? byte - last - 1 : GAP_BINS - 1]++;
+			last = byte;
+			marks &= ~(LHS_ONE >> __builtin_clzll(marks));
+		}
+	}
+
+	/* the chance of a complete gap of g starting at each byte, summed over the bytes -	*/
+	/* the sum for the last bin is in closed form						*/
+	for(g = 0; g < GAP_BINS - 1; g++) {
+		tally->gap_weight[g] += (length - g - 1)*GAP_P*weight;
+		weight *= q;
+	}
+	tally->gap_weight[GAP_BINS - 1] += weight*(length - GAP_BINS - q/GAP_P);
+
+}
+
+/* sort n 24-bit values by three byte passes, into tmp and back via buf */
+static inline void radix24(uint32_t *buf, uint32_t *tmp, int n) {
+
+	int count[256], pass, i, sum, c;
+	uint32_t *from = buf, *to = tmp, *swap;
+
+	for(pass = 0; pass < 24; pass += 8) {
+		memset(count, 0, sizeof(count));
+		for(i = 0; i < n; i++)
+			count[(*(from + i) >> pass) & 0xFF]++;
+		for(i = sum = 0; i < 256; i++) {
+			c = count[i];
+			count[i] = sum;
+			sum += c;
+		}
+		for(i = 0; i < n; i++)
+			*(to + count[(*(from + i) >> pass) & 0xFF]++) = *(from + i);
+		swap = from;
+		from = to;
+		to = swap;
+	}
+
+	/* three passes leave the result in tmp */
+	memcpy(buf, from, n*sizeof(uint32_t));
+
+}
+
+/* birthday spacings - the birthdays are the top 24 bits of each 32-bit half word, the	*/
+/* spacings between the sorted birthdays are taken around the year and the number of	*/
+/* spacings equal to another is Poisson with mean BDAY_LAMBDA				*/
+static inline void birthdays(const uint64_t *buf, size_t n, struct tally *tally) {
+
+	uint32_t day[BDAY_COUNT], space[BDAY_COUNT], tmp[BDAY_COUNT];
+	size_t i;
+	int j, dups;
+
+	for(i = 0; (i < BDAY_SAMPLES*BDAY_COUNT/2) && (i + BDAY_COUNT/2 <= n); i += BDAY_COUNT/2) {
+
+		for(j = 0; j < BDAY_COUNT/2; j++) {
+			day[2*j] = *(buf + i + j) >> 40;
+			day[2*j + 1] = (*(buf + i + j) >> 8) & (BDAY_DAYS - 1);
+		}
+		radix24(day, tmp, BDAY_COUNT);
+
+		space[0] = (day[0] - day[BDAY_COUNT - 1]) & (BDAY_DAYS - 1);
+		for(j = 1; j < BDAY_COUNT; j++)
+			space[j] = day[j] - day[j - 1];
+		radix24(space, tmp, BDAY_COUNT);
+
+		for(j = 1, dups = 0; j < BDAY_COUNT; j++)
+			dups += (space[j] == space[j - 1]);
+		tally->bday[(dups < BDAY_BINS - 1) ? dups : BDAY_BINS - 1]++;
+
+	}
+
+}
+
+/* 64 bits of the bit array reg from bit first on, least significant bit first */
+#define LC_BITS64(reg, first)	(((first) & 63) ? ((*((reg) + ((first) >> 6)) >> ((first) & 63)) | (*((reg) + ((first) >> 6) + 1) << (64 - ((first) & 63)))) \
+					       : *((reg) + ((first) >> 6)))
+
+/* linear complexity of LC_BITS bits by Berlekamp-Massey, a word of the connection	*/
+/* polynomial at a time.  The polynomials hold coefficient i in bit i and the block is	*/
+/* reversed, least significant bit first, so that the discrepancy at bit N is the parity	*/
+/* of the polynomial and the block from bit LC_BITS - 1 - N on, ANDed word by word.	*/
+static inline int linear_complexity(const uint64_t *block) {
+
+	uint64_t rev[LC_WORDS + 1] = { 0 }, conn[LC_WORDS] = { 0 }, prev[LC_WORDS] = { 0 }, save[LC_WORDS];
+	uint64_t d;
+	int N, L = 0, m = -1, w, words, shift, bits, first;
+
+	for(w = 0; w < LC_BITS/64; w++)
+		rev[w] = *(block + LC_BITS/64 - 1 - w);
+	conn[0] = prev[0] = RHS_ONE;
+
+	for(N = 0; N < LC_BITS; N++) {
+
+		first = LC_BITS - 1 - N;
+		words = (N >> 6) + 1;
+		for(w = 0, d = 0; w < words; w++)
+			d ^= conn[w] & LC_BITS64(rev, first + 64*w);
+		if(!__builtin_parityll(d))
+			continue;
+
+		/* conn ^= prev << (N - m) */
+		memcpy(save, conn, sizeof(conn));
+		shift = (N - m) >> 6;
+		bits = (N - m) & 63;
+		for(w = LC_WORDS - 1; w >= shift; w--)
+			conn[w] ^= (prev[w - shift] << bits) | ((bits && (w > shift)) ? prev[w - shift - 1] >> (64 - bits) : 0);
+
+		if(2*L <= N) {
+			L = N + 1 - L;
+			m = N;
+			memcpy(prev, save, sizeof(prev));
+		}
+
+	}
+
+	return(L);
+
+}
+
+/* everything about a chunk, but the transition into the next one */
+void test_chunk(const uint64_t *buf, size_t n, struct tally *tally) {
+
+	uint64_t counts[2] = { 0, 0 };
+	size_t i;
+	int T;
+
+	count_bits_dispatch(buf, n, counts);
+	tally->words += n;
+	tally->ones += counts[0];
+	tally->transitions += counts[1];
+
+	histogram(buf, n, tally->hist);
+	gaps(buf, n, tally);
+	birthdays(buf, n, tally);
+
+	/* T = L - LC_BITS/2 for an even block length, binned at -3 and below .. 3 and above */
+	for(i = 0; (i < LC_BLOCKS) && ((i + 1)*(LC_BITS/64) <= n); i++) {
+		T = linear_complexity(buf + i*(LC_BITS/64)) - LC_BITS/2;
+		tally->lc[(T < -3) ? 0 : (T > 3) ? LC_BINS - 1 : T + 3]++;
+	}
+
+}
+
+/* a worker thread - test chunks until the reader is done and the queue empty */
+void *worker(void *arg) {
+
+	struct worker *self = (struct worker *)arg;
+	struct queue *queue = self->queue;
+	struct chunk *chunk;
+
+	while(1) {
+
+		pthread_mutex_lock(&queue->lock);
+		while((queue->taken == queue->filled) && !queue->done)
+			pthread_cond_wait(&queue->cond, &queue->lock);
+		if(queue->taken == queue->filled) {
+			pthread_mutex_unlock(&queue->lock);
+			break;
+		}
+		chunk = &queue->chunk[queue->taken++ % queue->depth];
+		pthread_mutex_unlock(&queue->lock);
+
+		test_chunk(chunk->buf, chunk->words, self->tally);
+
+		pthread_mutex_lock(&queue->lock);
+		chunk->busy = 0;
+		pthread_cond_broadcast(&queue->cond);
+		pthread_mutex_unlock(&queue->lock);
+
+	}
+
+	return(NULL);
+
+}
+
+/* one line of results */
+void result(char *name, double p, char *detail) {
+
+	printf("%-10s %.3e%s  %s\n", name, p, (p < SUSPECT) ? " <--" : "    ", detail);
+
+}
+
+/* the chi-square p-value of counts against probabilities, n/a unless every bin expects 5 */
+void chisq_result(char *name, uint64_t *count, double *prob, int bins, char *detail) {
+
+	uint64_t total = 0;
+	double chisq = 0, expected;
+	int i;
+
+	for(i = 0; i < bins; i++)
+		total += *(count + i);
+	for(i = 0; i < bins; i++) {
+		expected = total*(*(prob + i));
+		if(expected < 5.0) {
+			printf("%-10s n/a            %s (too few samples)\n", name, detail);
+			return;
+		}
+		chisq += (*(count + i) - expected)*(*(count + i) - expected)/expected;
+	}
+
+	result(name, chisq_p(chisq, bins - 1), detail);
+
+}
+
+void report(struct tally *tally, double seconds) {
+
+	static uint64_t nibble[16], byte[256];
+	static double uniform[3][1 << 16];
+	double bits = 64.0*tally->words, pi, total, prob[GAP_BINS];
+	double bday_prob[BDAY_BINS], lc_prob[LC_BINS] = { 0.010417, 0.03125, 0.125, 0.5, 0.25, 0.0625, 0.020833 };
+	char detail[64];
+	int i, k;
+
+	printf("# %llu bytes in %.2f s, %.1f MB/s, %s kernels, p-values below %.0e flagged\n",
+		(unsigned long long)(8*tally->words), seconds, 8.0*tally->words/seconds/1.0e6, ca_kernel_name(), SUSPECT);
+	if(!tally->words)
+		return;
+
+	sprintf(detail, "%.6f ones", tally->ones/bits);
+	result("monobit", normal_p((2.0*tally->ones - bits)/sqrt(bits)), detail);
+
+	pi = tally->ones/bits;
+	sprintf(detail, "%llu runs", (unsigned long long)(tally->transitions + 1));
+	if(fabs(pi - 0.5) >= 2.0/sqrt(bits))
+		result("runs", 0.0, detail);	/* the monobit prerequisite fails */
+	else
+		result("runs", erfc(fabs(tally->transitions + 1 - 2.0*bits*pi*(1.0 - pi))/(2.0*sqrt(2.0*bits)*pi*(1.0 - pi))), detail);
+
+	/* the poker and serial tests from the 16-bit histogram */
+	for(i = 0; i < (1 << 16); i++) {
+		for(k = 0; k < 16; k += 4)
+			nibble[(i >> k) & 0xF] += tally->hist[i];
+		byte[i >> 8] += tally->hist[i];
+		byte[i & 0xFF] += tally->hist[i];
+		uniform[0][i] = 1.0/16;
+		uniform[1][i] = 1.0/256;
+		uniform[2][i] = 1.0/(1 << 16);
+	}
+	chisq_result("poker4", nibble, uniform[0], 16, "4-bit blocks, 15 dof");
+	chisq_result("poker8", byte, uniform[1], 256, "8-bit blocks, 255 dof");
+	chisq_result("serial", tally->hist, uniform[2], 1 << 16, "byte pairs, 65535 dof");
+
+	for(i = 0, total = 0; i < GAP_BINS; i++)
+		total += tally->gap_weight[i];
+	for(i = 0; i < GAP_BINS; i++)
+		prob[i] = tally->gap_weight[i]/total;
+	sprintf(detail, "bytes below 32, %d dof", GAP_BINS - 1);
+	chisq_result("gap", tally->gap, prob, GAP_BINS, detail);
+
+	for(i = 0, total = 0; i < BDAY_BINS - 1; i++) {
+		bday_prob[i] = exp(-BDAY_LAMBDA)*pow(BDAY_LAMBDA, i)/tgamma(i + 1.0);
+		total += bday_prob[i];
+	}
+	bday_prob[BDAY_BINS - 1] = 1.0 - total;
+	sprintf(detail, "%d birthdays in 2^24 days, %d dof", BDAY_COUNT, BDAY_BINS - 1);
+	chisq_result("birthday", tally->bday, bday_prob, BDAY_BINS, detail);
+
+	sprintf(detail, "%d-bit blocks, %d dof", LC_BITS, LC_BINS - 1);
+	chisq_result("linear", tally->lc, lc_prob, LC_BINS, detail);
+
+}
+
+void usage(char *progname) {
+
+	fprintf(stderr, "usage: %s [-j threads] [-c bytes] [-g center|taps|counter] [-s seed]\n", progname);
+	fprintf(stderr, "\t-c\tbytes to test (k, M, G and T suffixes allowed), all of stdin by default\n");
+	fprintf(stderr, "\t-g\ttest a built-in generator instead of stdin, %lluM bytes by default\n", GEN_BYTES >> 20);
+	exit(1);
+
+}
+
+/* a byte count with an optional k, M, G or T suffix */
+unsigned long long byte_count(char *arg) {
+
+	char *end;
+	unsigned long long count = strtoull(arg, &end, 0);
+
+	switch(*end) {
+		case 'k':
+			return(count << 10);
+		case 'M':
+			return(count << 20);
+		case 'G':
+			return(count << 30);
+		case 'T':
+			return(count << 40);
+		case '\0':
+			return(count);
+		default:
+			return(0);
+	}
+
+}
+
+int main(int argc, char **argv) {
+
+	int c, i, threads, generator = GEN_STDIN;
+	unsigned long int seed = 1234523;
+	unsigned long long limit = 0;
+	uint64_t words, position = 0, last = 0;
+	size_t bytes, got;
+	struct queue queue;
+	struct worker *workers;
+	struct chunk *chunk;
+	struct tally *total;
+	struct rule30_rng_state state;
+	struct rule30_taps taps;
+	struct rule30_ctr_key key;
+	struct timespec start, end;
+
+	threads = sysconf(_SC_NPROCESSORS_ONLN);
+	while((c = getopt(argc, argv, "j:c:g:s:")) != -1) {
+		switch(c) {
+			case 'j':
+				threads = atoi(optarg);
+				break;
+			case 'c':
+				if(!(limit = byte_count(optarg)))
+					usage((char *)argv[0]);
+				break;
+			case 'g':
+				if(!strcmp(optarg, "center"))
+					generator = GEN_CENTER;
+				else if(!strcmp(optarg, "taps"))
+					generator = GEN_TAPS;
+				else if(!strcmp(optarg, "counter"))
+					generator = GEN_COUNTER;
+				else
+					usage((char *)argv[0]);
+				break;
+			case 's':
+				seed = strtoul(optarg, NULL, 0);
+				break;
+			default:
+				usage((char *)argv[0]);
+		}
+	}
+	if((threads < 1) || (optind != argc)) usage((char *)argv[0]);
+	if(generator && !limit)
+		limit = GEN_BYTES;
+
+	switch(generator) {
+		case GEN_CENTER:
+			rule30_rng_init(&state, seed);
+			break;
+		case GEN_TAPS:
+			rule30_taps_default(&taps);
+			rule30_rng_init_full(&state, seed);
+			break;
+		case GEN_COUNTER:
+			rule30_ctr_init(&key, seed);
+			break;
+	}
+
+	/* two chunks a worker, so that the reader never waits for a slow one */
+	queue.depth = 2*threads;
+	queue.filled = queue.taken = 0;
+	queue.done = 0;
+	queue.chunk = (struct chunk *)calloc(queue.depth, sizeof(struct chunk));
+	workers = (struct worker *)calloc(threads, sizeof(struct worker));
+	total = (struct tally *)calloc(1, sizeof(struct tally));
+	if(!queue.chunk || !workers || !total) {
+		fprintf(stderr, "couldn't allocate working memory\n");
+		exit(1);
+	}
+	for(i = 0; i < queue.depth; i++) {
+		if(!(queue.chunk[i].buf = (uint64_t *)malloc(CHUNK_WORDS*sizeof(uint64_t)))) {
+			fprintf(stderr, "couldn't allocate working memory\n");
+			exit(1);
+		}
+	}
+	pthread_mutex_init(&queue.lock, NULL);
+	pthread_cond_init(&queue.cond, NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < threads; i++) {
+		workers[i].queue = &queue;
+		if(!(workers[i].tally = (struct tally *)calloc(1, sizeof(struct tally)))) {
+			fprintf(stderr, "couldn't allocate working memory\n");
+			exit(1);
+		}
+		if(pthread_create(&workers[i].thread, NULL, worker, &workers[i])) {
+			fprintf(stderr, "couldn't start thread %d\n", i);
+			exit(1);
+		}
+	}
+
+	/* read or generate chunk after chunk, counting the transitions between them here */
+	while(!limit || (position < limit/sizeof(uint64_t))) {
+
+		pthread_mutex_lock(&queue.lock);
+		chunk = &queue.chunk[queue.filled % queue.depth];
+		while(chunk->busy)
+			pthread_cond_wait(&queue.cond, &queue.lock);
+		pthread_mutex_unlock(&queue.lock);
+
+		words = CHUNK_WORDS;
+		if(limit && (words > limit/sizeof(uint64_t) - position))
+			words = limit/sizeof(uint64_t) - position;
+
+		switch(generator) {
+			case GEN_STDIN:
+				for(bytes = 0; bytes < words*sizeof(uint64_t); bytes += got)
+					if(!(got = fread((char *)chunk->buf + bytes, 1, words*sizeof(uint64_t) - bytes, stdin)))
+						break;
+				words = bytes/sizeof(uint64_t);
+				break;
+			case GEN_CENTER:
+				rule30_rng_fill_u64_dispatch(&state, chunk->buf, words);
+				break;
+			case GEN_TAPS:
+				rule30_rng_fill_u64_taps_dispatch(&state, &taps, chunk->buf, words);
+				break;
+			case GEN_COUNTER:
+				rule30_ctr_fill_u64(&key, position, chunk->buf, words);
+				break;
+		}
+		if(!words)
+			break;
+
+		if(position)
+			total->transitions += ((last ^ (*chunk->buf >> 63)) & RHS_ONE);
+		last = *(chunk->buf + words - 1);
+		position += words;
+
+		pthread_mutex_lock(&queue.lock);
+		chunk->words = words;
+		chunk->busy = 1;
+		queue.filled++;
+		pthread_cond_broadcast(&queue.cond);
+		pthread_mutex_unlock(&queue.lock);
+
+	}
+
+	pthread_mutex_lock(&queue.lock);
+	queue.done = 1;
+	pthread_cond_broadcast(&queue.cond);
+	pthread_mutex_unlock(&queue.lock);
+
+	for(i = 0; i < threads; i++) {
+		pthread_join(workers[i].thread, NULL);
+		total->words += workers[i].tally->words;
+		total->ones += workers[i].tally->ones;
+		total->transitions += workers[i].tally->transitions;
+		for(c = 0; c < (1 << 16); c++)
+			total->hist[c] += workers[i].tally->hist[c];
+		for(c = 0; c < GAP_BINS; c++) {
+			total->gap[c] += workers[i].tally->gap[c];
+			total->gap_weight[c] += workers[i].tally->gap_weight[c];
+		}
+		for(c = 0; c < BDAY_BINS; c++)
+			total->bday[c] += workers[i].tally->bday[c];
+		for(c = 0; c < LC_BINS; c++)
+			total->lc[c] += workers[i].tally->lc[c];
+		free(workers[i].tally);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	report(total, (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec)/1.0e9);
+
+	for(i = 0; i < queue.depth; i++)
+		free(queue.chunk[i].buf);
+	free(queue.chunk);
+	free(workers);
+	free(total);
+	exit(0);
+
+}
@@ -0,0 +1,85 @@
+/************************************************************************/
+/* The bit counts of rule30battery					*/
+/*									*/
+/* The monobit and runs tests of "rule30.battery.c" need the ones and	*/
+/* the bit transitions of every word of the stream.  The popcount	*/
+/* behind them is compiled for each instruction set and picked at	*/
+/* startup by ca.dispatch.h:						*/
+/*									*/
+/*	count_bits()		ones and transitions of n words		*/
+/*	count_bits_avx2()	the same four words at a time		*/
+/*	count_bits_dispatch()	the variant of the CPU			*/
+/*									*/
+/* The kernels live in this header so that "rule30.verify.c" can run	*/
+/* every variant against a per-bit count.				*/
+/************************************************************************/
+
+#ifndef RULE30_BATTERY_H
+#define RULE30_BATTERY_H
+
+#include "rule30.rng.h"
+
+/* ones and bit transitions in n words, counting the transitions inside buf only - the	*/
+/* last word's low bit is compared with nothing					*/
+static inline void count_bits(const uint64_t *buf, size_t n, uint64_t *counts) {
+
+	size_t i;
+	uint64_t ones = 0, transitions = 0;
+
+	for(i = 0; i + 1 < n; i++) {
+		ones += __builtin_popcountll(*(buf + i));
+		transitions += __builtin_popcountll(*(buf + i) ^ ((*(buf + i) << 1) | (*(buf + i + 1) >> 63)));
+	}
+	if(n) {
+		ones += __builtin_popcountll(*(buf + i));
+		transitions += __builtin_popcountll((*(buf + i) ^ (*(buf + i) << 1)) & ~RHS_ONE);
+	}
+
+	*counts += ones;
+	*(counts + 1) += transitions;
+
+}
+
+#if defined(__x86_64__)
+/* the byte counts of four words by a nibble table lookup, summed into the four lanes */
+#define POPCOUNT_AVX2(v)	_mm256_sad_epu8(_mm256_add_epi8(_mm256_shuffle_epi8(table, _mm256_and_si256((v), low)),	\
+						_mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi64((v), 4), low))),	\
+						_mm256_setzero_si256())
+
+/* count_bits() four words at a time with AVX2, which has no popcount of its own */
+static inline CA_TARGET_AVX2 void count_bits_avx2(const uint64_t *buf, size_t n, uint64_t *counts) {
+
+	size_t i;
+	__m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+					 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	__m256i low = _mm256_set1_epi8(0x0F), ones = _mm256_setzero_si256(), transitions = _mm256_setzero_si256();
+	__m256i word, next;
+	uint64_t lanes[4];
+
+	for(i = 0; i + 4 < n; i += 4) {
+		word = _mm256_loadu_si256((const __m256i *)(buf + i));
+		next = _mm256_loadu_si256((const __m256i *)(buf + i + 1));
+		ones = _mm256_add_epi64(ones, POPCOUNT_AVX2(word));
+		word = _mm256_xor_si256(word, _mm256_or_si256(_mm256_slli_epi64(word, 1), _mm256_srli_epi64(next, 63)));
+		transitions = _mm256_add_epi64(transitions, POPCOUNT_AVX2(word));
+	}
+
+	_mm256_storeu_si256((__m256i *)lanes, ones);
+	*counts += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	_mm256_storeu_si256((__m256i *)lanes, transitions);
+	*(counts + 1) += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+	/* the vector part counted the transition into the last words */
+	count_bits(buf + i, n - i, counts);
+
+}
+#else
+#define count_bits_avx2		count_bits
+#endif /* __x86_64__ */
+
+/* the bit counts compiled for each instruction set - the popcnt instruction from BMI2 up,	*/
+/* the nibble lookup for AVX2 and AVX-512 (whose vpopcntq is an extension of its own)	*/
+CA_DISPATCH_VARIANTS(count_bits_dispatch, count_bits, count_bits, count_bits_avx2, count_bits_avx2,
+		     (const uint64_t *buf, size_t n, uint64_t *counts), (buf, n, counts))
+
+#endif /* RULE30_BATTERY_H */
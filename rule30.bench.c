@@ -0,0 +1,518 @@
+/************************************************************************/
+/* Benchmark suite for the rule 30 generator and cipher			*/
+/*									*/
+/* Replaces the old #ifdef BENCHMARK loops, which called clock() on	*/
+/* every iteration and so timed clock() as much as the generator.  Each	*/
+/* interface is timed on its own with a cycle counter (the TSC on x86,	*/
+/* the monotonic clock elsewhere) and the suite reports			*/
+/*									*/
+/*	throughput	bytes/s and cycles/byte of bulk calls into a	*/
+/*			buffer that stays in cache			*/
+/*	latency		percentiles of single calls of one unit each,	*/
+/*			warm and with the state and output flushed from	*/
+/*			the caches before every call (cold)		*/
+/*	width sweep	bytes/s of the center-column generator for	*/
+/*			lattices of 1 to 32 registers			*/
+/*									*/
+/* either as a table or, with -j, as JSON for tracking regressions from	*/
+/* release to release.  Cycles are TSC reference cycles, which match	*/
+/* core cycles only with frequency scaling off.  -t sets the seconds	*/
+/* spent per throughput measurement and -n the samples per latency	*/
+/* measurement.								*/
+/*									*/
+/*	rule30bench [-j] [-t seconds] [-n samples]			*/
+/*									*/
+/* compile with:							*/
+/*	gcc -O3 -march=native -o rule30bench rule30.bench.c -lm		*/
+/************************************************************************/
+
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif /* __x86_64__ */
+
+#include "rule30.rng.h"
+#include "rule30.simd.h"
+#include "rule30.cone.h"
+#include "rule30.ctr.h"
+#include "rule30.dist.h"
+#include "rule30.crypt.h"
+
+#define BUFFER_BYTES	(64 << 10)	/* throughput buffer, stays in L2 */
+#define LINE_BYTES	64
+#define EVICT_BYTES	(64 << 20)	/* larger than any last level cache */
+#define SWEEP_MAX	32		/* registers in the widest swept lattice */
+#define SEED_BENCH	1234523
+
+/* an interface under test: run() produces bytes (a multiple of unit) into buf */
+struct bench_target {
+
+	char *name;
+	size_t unit;
+	void (*run)(void *state, void *buf, size_t bytes);
+	void *state;
+	size_t state_size;
+
+};
+
+double ticks_per_second;
+int json = 0;
+
+/* the cycle counter */
+static inline uint64_t bench_ticks(void) {
+
+#if defined(__x86_64__) || defined(__i386__)
+	return(__rdtsc());
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return((uint64_t)now.tv_sec*1000000000ULL + now.tv_nsec);
+#endif /* __x86_64__ */
+
+}
+
+double bench_seconds(void) {
+
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return(now.tv_sec + now.tv_nsec*1.0e-9);
+
+}
+
+/* ticks per second of the cycle counter, against the monotonic clock */
+void calibrate(void) {
+
+	double start = bench_seconds(), end;
+	uint64_t ticks = bench_ticks();
+
+	while((end = bench_seconds()) - start < 0.1);
+	ticks_per_second = (bench_ticks() - ticks)/(end - start);
+
+}
+
+/* push len bytes at p out of every cache level */
+void flush(void *p, size_t len) {
+
+#if defined(__x86_64__) || defined(__i386__)
+	char *c;
+
+	for(c = (char *)p; c < (char *)p + len; c += LINE_BYTES)
+		_mm_clflush(c);
+	_mm_clflush((char *)p + len - 1);
+	_mm_mfence();
+#else
+	static volatile char *evict = NULL;
+	size_t i;
+
+	if(!evict)
+		evict = (volatile char *)calloc(EVICT_BYTES, 1);
+	for(i = 0; evict && (i < EVICT_BYTES); i += LINE_BYTES)
+		evict[i]++;
+#endif /* __x86_64__ */
+
+}
+
+/* the interfaces */
+void run_next(void *state, void *buf, size_t bytes) {
+
+	size_t i;
+
+	for(i = 0; i < bytes/sizeof(double); i++)
+		*((double *)buf + i) = rule30_rng_next((struct rule30_rng_state *)state);
+
+}
+
+void run_fill_u64(void *state, void *buf, size_t bytes) {
+
+	rule30_rng_fill_u64((struct rule30_rng_state *)state, (uint64_t *)buf, bytes/sizeof(uint64_t));
+
+}
+
+void run_fill_double(void *state, void *buf, size_t bytes) {
+
+	rule30_rng_fill_double((struct rule30_rng_state *)state, (double *)buf, bytes/sizeof(double));
+
+}
+
+/* the bulk call of the kernel chosen at startup, see ca.dispatch.h - set CA_KERNEL to compare */
+void run_dispatch(void *state, void *buf, size_t bytes) {
+
+	rule30_rng_fill_u64_dispatch((struct rule30_rng_state *)state, (uint64_t *)buf, bytes/sizeof(uint64_t));
+
+}
+
+/* the same numbers as run_next, so the two rows compare the bulk call against the loop */
+void run_dispatch_double(void *state, void *buf, size_t bytes) {
+
+	rule30_rng_fill_double_dispatch((struct rule30_rng_state *)state, (double *)buf, bytes/sizeof(double));
+
+}
+
+/* the tap set rides along after the stream state */
+struct taps_state {
+
+	struct rule30_rng_state rng;
+	struct rule30_taps taps;
+
+};
+
+void run_fill_taps(void *state, void *buf, size_t bytes) {
+
+	struct taps_state *s = (struct taps_state *)state;
+
+	rule30_rng_fill_u64_taps(&s->rng, &s->taps, (uint64_t *)buf, bytes/sizeof(uint64_t));
+
+}
+
+/* and the tables after the stream state of the light-cone engine */
+struct cone_state {
+
+	struct rule30_rng_state rng;
+	struct rule30_cone cone;
+
+};
+
+void run_cone(void *state, void *buf, size_t bytes) {
+
+	struct cone_state *s = (struct cone_state *)state;
+
+	rule30_cone_fill_u64(&s->cone, &s->rng, (uint64_t *)buf, bytes/sizeof(uint64_t));
+
+}
+
+void run_simd(void *state, void *buf, size_t bytes) {
+
+	rule30_simd_fill_u64((struct rule30_simd_state *)state, (uint64_t *)buf, bytes/sizeof(uint64_t));
+
+}
+
+struct ctr_state {
+
+	struct rule30_ctr_key key;
+	uint64_t next;
+
+};
+
+void run_ctr(void *state, void *buf, size_t bytes) {
+
+	struct ctr_state *s = (struct ctr_state *)state;
+
+	rule30_ctr_fill_u64(&s->key, s->next, (uint64_t *)buf, bytes/sizeof(uint64_t));
+	s->next += bytes/sizeof(uint64_t);
+
+}
+
+struct zig_state {
+
+	struct rule30_rng_state rng;
+	struct rule30_zig zig;
+
+};
+
+void run_normal(void *state, void *buf, size_t bytes) {
+
+	struct zig_state *s = (struct zig_state *)state;
+
+	rule30_dist_fill_normal(&s->rng, &s->zig, (double *)buf, bytes/sizeof(double));
+
+}
+
+void run_bounded(void *state, void *buf, size_t bytes) {
+
+	rule30_dist_fill_bounded((struct rule30_rng_state *)state, 1000, (uint32_t *)buf, bytes/sizeof(uint32_t));
+
+}
+
+void run_encrypt(void *state, void *buf, size_t bytes) {
+
+	unsigned long int *block = (unsigned long int *)buf;
+	size_t i;
+
+	/* chain the blocks so that each encryption depends on the last */
+	for(i = 0; i < bytes/(4*sizeof(unsigned long int)); i++, block += 4)
+		xr30256_encrypt_dispatch((struct scheduled_key *)state, (i ? block - 4 : block), block);
+
+}
+
+/* the width sweep - one generator per lattice width, the center column as in fill_u64 */
+#define SWEEP_DEFINE(regs)												\
+															\
+CA_LATTICE_DEFINE(sweep_lattice_##regs, unsigned long int, regs, WORDSIZE)						\
+															\
+void run_sweep_##regs(void *state, void *buf, size_t bytes) {								\
+															\
+	register unsigned long int rule = RULE30;									\
+	register unsigned long long int random_result_int;								\
+	sweep_lattice_##regs lattice;											\
+	size_t i;													\
+	int j;														\
+															\
+	memcpy(lattice.reg, state, sizeof(lattice.reg));								\
+	for(i = 0; i < bytes/sizeof(uint64_t); i++) {									\
+		random_result_int = 0;											\
+		for(j = 0; j < 64; j++) {										\
+			sweep_lattice_##regs##_step(&lattice, rule);							\
+			random_result_int = (random_result_int << RHS_ONE) | ((lattice.reg[(regs) / 2] & CENTER_MASK) >> DELTA_CENTER);	\
+		}													\
+		*((uint64_t *)buf + i) = random_result_int;								\
+	}														\
+	memcpy(state, lattice.reg, sizeof(lattice.reg));								\
+															\
+}
+
+SWEEP_DEFINE(1)
+SWEEP_DEFINE(2)
+SWEEP_DEFINE(4)
+SWEEP_DEFINE(7)
+SWEEP_DEFINE(8)
+SWEEP_DEFINE(16)
+SWEEP_DEFINE(32)
+
+struct sweep {
+
+	int regs;
+	void (*run)(void *state, void *buf, size_t bytes);
+
+} sweeps[] = {
+
+	{ 1, run_sweep_1 }, { 2, run_sweep_2 }, { 4, run_sweep_4 }, { 7, run_sweep_7 },
+	{ 8, run_sweep_8 }, { 16, run_sweep_16 }, { 32, run_sweep_32 }
+
+};
+
+/* a fully seeded lattice of SWEEP_MAX registers, splitmix64 as rule30_rng_init_full() */
+void seed_sweep(unsigned long int *reg, unsigned long int seed) {
+
+	uint64_t z = seed, x;
+	int i;
+
+	for(i = 0; i < SWEEP_MAX; i++) {
+		z += 0x9E3779B97F4A7C15ULL;
+		x = z;
+		x = (x ^ (x >> 30))*0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27))*0x94D049BB133111EBULL;
+		*(reg + i) = x ^ (x >> 31);
+	}
+
+}
+
+/* bulk throughput, bytes per second and ticks per byte, over at least seconds */
+void throughput(void (*run)(void *, void *, size_t), void *state, void *buf, size_t bytes, double seconds, double *rate, double *cycles) {
+
+	double start, end;
+	uint64_t ticks, total = 0;
+
+	run(state, buf, bytes);		/* warm up */
+
+	start = bench_seconds();
+	ticks = bench_ticks();
+	do {
+		run(state, buf, bytes);
+		total += bytes;
+		end = bench_seconds();
+	} while(end - start < seconds);
+	ticks = bench_ticks() - ticks;
+
+	*rate = total/(end - start);
+	*cycles = (double)ticks/total;
+
+}
+
+int compare_ticks(const void *a, const void *b) {
+
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return((x > y) - (x < y));
+
+}
+
+/* latency percentiles in ns of single calls of one unit, cold if the caches are flushed first */
+void latency(struct bench_target *target, void *buf, int samples, int cold, double *percentile) {
+
+	static const double points[5] = { 0.50, 0.90, 0.99, 0.999, 1.0 };
+	uint64_t *sample, ticks;
+	int i;
+
+	sample = (uint64_t *)calloc(samples, sizeof(uint64_t));
+	if(!sample) {
+		fprintf(stderr, "couldn't allocate latency samples\n");
+		exit(1);
+	}
+
+	for(i = 0; i < samples; i++) {
+
+		if(cold) {
+			flush(target->state, target->state_size);
+			flush(buf, target->unit);
+		}
+
+		ticks = bench_ticks();
+		target->run(target->state, buf, target->unit);
+		*(sample + i) = bench_ticks() - ticks;
+
+	}
+
+	qsort(sample, samples, sizeof(uint64_t), compare_ticks);
+	for(i = 0; i < 5; i++)
+		*(percentile + i) = *(sample + (int)ceil(points[i]*samples) - 1)*1.0e9/ticks_per_second;
+
+	free(sample);
+
+}
+
+void usage(char *progname) {
+
+	fprintf(stderr, "usage: %s [-j] [-t seconds] [-n samples]\n", progname);
+	fprintf(stderr, "\t-j\tJSON output\n");
+	fprintf(stderr, "\t-t\tseconds per throughput measurement\n");
+	fprintf(stderr, "\t-n\tsamples per latency measurement\n");
+	exit(1);
+
+}
+
+int main(int argc, char **argv) {
+
+	int c, i, cold;
+	int samples = 10000, targets;
+	double seconds = 0.5, rate, cycles, percentile[5];
+	void *buf;
+	unsigned long int seeds[RNG_LANES];
+	unsigned long int key[4] = { 0xa59535d07e192f12, 0x82734fb3084c5e05, 0x385b8a038d28e669, 0xd2bc44a82c395d8e };
+	unsigned long int sweep_state[SWEEP_MAX];
+	struct rule30_rng_state next_state, u64_state, double_state, dispatch_state, dispatch_double_state, bounded_state;
+	struct taps_state taps_state;
+	static struct cone_state cone_state;
+	struct rule30_simd_state simd_state;
+	struct ctr_state ctr_state;
+	struct zig_state zig_state;
+	struct scheduled_key *skey;
+	struct bench_target target[] = {
+
+		{ "rng_next",		sizeof(double),			run_next,	&next_state,	sizeof(next_state) },
+		{ "rng_fill_u64",	sizeof(uint64_t),		run_fill_u64,	&u64_state,	sizeof(u64_state) },
+		{ "rng_fill_double",	sizeof(double),			run_fill_double, &double_state,	sizeof(double_state) },
+		{ "rng_dispatch_u64",	sizeof(uint64_t),		run_dispatch,	&dispatch_state, sizeof(dispatch_state) },
+		{ "rng_dispatch_double", sizeof(double),			run_dispatch_double, &dispatch_double_state, sizeof(dispatch_double_state) },
+		{ "rng_fill_u64_taps",	sizeof(uint64_t),		run_fill_taps,	&taps_state,	sizeof(taps_state) },
+		{ "cone_fill_u64",	sizeof(uint64_t),		run_cone,	&cone_state,	sizeof(cone_state) },
+		{ "simd_fill_u64",	RNG_LANES*sizeof(uint64_t),	run_simd,	&simd_state,	sizeof(simd_state) },
+		{ "ctr_fill_u64",	CTR_WORDS*sizeof(uint64_t),	run_ctr,	&ctr_state,	sizeof(ctr_state) },
+		{ "dist_fill_normal",	sizeof(double),			run_normal,	&zig_state,	sizeof(zig_state) },
+		{ "dist_fill_bounded",	2*sizeof(uint32_t),		run_bounded,	&bounded_state,	sizeof(bounded_state) },
+		{ "xr30256_encrypt",	4*sizeof(unsigned long int),	run_encrypt,	NULL,		sizeof(struct scheduled_key) }
+
+	};
+
+	while((c = getopt(argc, argv, "jt:n:")) != -1) {
+		switch(c) {
+			case 'j':
+				json = 1;
+				break;
+			case 't':
+				seconds = atof(optarg);
+				break;
+			case 'n':
+				samples = atoi(optarg);
+				break;
+			default:
+				usage((char *)argv[0]);
+		}
+	}
+	if((seconds <= 0) || (samples < 1) || (optind < argc)) usage((char *)argv[0]);
+
+	if(posix_memalign(&buf, LINE_BYTES, BUFFER_BYTES)) {
+		fprintf(stderr, "couldn't allocate working memory buffer\n");
+		exit(1);
+	}
+	memset(buf, 0, BUFFER_BYTES);
+	targets = sizeof(target)/sizeof(target[0]);
+
+	/* set up every interface from the same seed */
+	rule30_rng_init(&next_state, SEED_BENCH);
+	rule30_rng_init(&u64_state, SEED_BENCH);
+	rule30_rng_init(&double_state, SEED_BENCH);
+	rule30_rng_init(&dispatch_state, SEED_BENCH);
+	rule30_rng_init(&dispatch_double_state, SEED_BENCH);
+	rule30_rng_init_full(&bounded_state, SEED_BENCH);
+	rule30_rng_init_full(&taps_state.rng, SEED_BENCH);
+	rule30_taps_default(&taps_state.taps);
+	rule30_rng_init(&cone_state.rng, SEED_BENCH);
+	rule30_cone_init(&cone_state.cone, RULE30);
+	for(i = 0; i < RNG_LANES; i++)
+		seeds[i] = SEED_BENCH + i;
+	rule30_simd_init(&simd_state, seeds);
+	rule30_ctr_init(&ctr_state.key, SEED_BENCH);
+	ctr_state.next = 0;
+	rule30_rng_init_full(&zig_state.rng, SEED_BENCH);
+	rule30_zig_init(&zig_state.zig);
+	skey = xr30256_key_schedule(key);
+	if(!skey) {
+		fprintf(stderr, "couldn't schedule the key\n");
+		exit(1);
+	}
+	target[targets - 1].state = skey;
+
+	calibrate();
+
+	if(json)
+		printf("{\n  \"ticks_per_second\": %.0f,\n  \"kernel\": \"%s\",\n  \"buffer_bytes\": %d,\n  \"seconds\": %g,\n  \"samples\": %d,\n", ticks_per_second, ca_kernel_name(), BUFFER_BYTES, seconds, samples);
+	else
+		printf("# counter %.3f GHz, %s kernel, %d kB buffer, %g s per throughput, %d samples per latency\n", ticks_per_second/1.0e9, ca_kernel_name(), BUFFER_BYTES >> 10, seconds, samples);
+
+	/* throughput */
+	if(json)
+		printf("  \"throughput\": [\n");
+	else
+		printf("\n%-20s %14s %12s\n", "throughput", "MB/s", "cycles/byte");
+	for(i = 0; i < targets; i++) {
+		throughput(target[i].run, target[i].state, buf, BUFFER_BYTES, seconds, &rate, &cycles);
+		if(json)
+			printf("    { \"name\": \"%s\", \"bytes_per_second\": %.0f, \"cycles_per_byte\": %.3f }%s\n", target[i].name, rate, cycles, (i < targets - 1) ? "," : "");
+		else
+			printf("%-20s %14.2f %12.2f\n", target[i].name, rate/1.0e6, cycles);
+	}
+
+	/* latency */
+	if(json)
+		printf("  ],\n  \"latency\": [\n");
+	else
+		printf("\n%-20s %5s %6s %10s %10s %10s %10s %10s\n", "latency (ns)", "cache", "bytes", "p50", "p90", "p99", "p99.9", "max");
+	for(i = 0; i < targets; i++) {
+		for(cold = 0; cold < 2; cold++) {
+			latency(&target[i], buf, samples, cold, percentile);
+			if(json)
+				printf("    { \"name\": \"%s\", \"cache\": \"%s\", \"bytes\": %zu, \"p50_ns\": %.1f, \"p90_ns\": %.1f, \"p99_ns\": %.1f, \"p999_ns\": %.1f, \"max_ns\": %.1f }%s\n",
+					target[i].name, cold ? "cold" : "warm", target[i].unit, percentile[0], percentile[1], percentile[2], percentile[3], percentile[4],
+					((i < targets - 1) || !cold) ? "," : "");
+			else
+				printf("%-20s %5s %6zu %10.1f %10.1f %10.1f %10.1f %10.1f\n", target[i].name, cold ? "cold" : "warm", target[i].unit,
+					percentile[0], percentile[1], percentile[2], percentile[3], percentile[4]);
+		}
+	}
+
+	/* lattice width */
+	if(json)
+		printf("  ],\n  \"width_sweep\": [\n");
+	else
+		printf("\n%-20s %14s %12s\n", "width (cells)", "MB/s", "cycles/byte");
+	for(i = 0; i < (int)(sizeof(sweeps)/sizeof(sweeps[0])); i++) {
+		seed_sweep(sweep_state, SEED_BENCH);
+		throughput(sweeps[i].run, sweep_state, buf, BUFFER_BYTES, seconds, &rate, &cycles);
+		if(json)
+			printf("    { \"cells\": %d, \"bytes_per_second\": %.0f, \"cycles_per_byte\": %.3f }%s\n", sweeps[i].regs*WORDSIZE, rate, cycles,
+				(i < (int)(sizeof(sweeps)/sizeof(sweeps[0])) - 1) ? "," : "");
+		else
+			printf("%-20d %14.2f %12.2f\n", sweeps[i].regs*WORDSIZE, rate/1.0e6, cycles);
+	}
+	if(json)
+		printf("  ]\n}\n");
+
+	free(skey);
+	free(buf);
+	exit(0);
+
+}
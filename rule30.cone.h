@@ -0,0 +1,150 @@
+/************************************************************************/
+/* Light-cone table engine for the rule 30 center column		*/
+/*									*/
+/* The generator keeps only the center column of the spacetime diagram,	*/
+/* and a cell k generations on depends only on the 2k + 1 cells of its	*/
+/* light cone.  This engine steps the lattice CONE_GENS generations at	*/
+/* a time by table lookup instead of a generation at a time by bitwise	*/
+/* arithmetic: the lattice is held a byte (8 cells) at a time, and	*/
+/*									*/
+/*	step[window]	the byte CONE_GENS generations on, from the	*/
+/*			byte and CONE_GENS cells either side of it	*/
+/*	center[window]	the CONE_GENS center bits to come, from the	*/
+/*			2*CONE_GENS + 1 cells around the center		*/
+/*									*/
+/* so each lookup stands in for CONE_GENS generations of 8 cells.  The	*/
+/* tables are built once for a rule by rule30_cone_init() and are read	*/
+/* only afterwards, so one set may be shared by any number of threads.	*/
+/* rule30_cone_fill_u64() takes and leaves a struct rule30_rng_state	*/
+/* and gives the same words, bit for bit, as rule30_rng_fill_u64(), so	*/
+/* the two engines may be switched freely within a stream.		*/
+/*									*/
+/* rule30rng -l selects it in place of the lattice engine, and the	*/
+/* cone_fill_u64 row of rule30.bench.c times the two against each other	*/
+/* on a given machine.  Against the vectorized lattice kernels of	*/
+/* ca.dispatch.h the table engine is the slower one (3.7 against 6.3	*/
+/* MB/s with AVX-512), since the light cone of the center column widens	*/
+/* by two cells a generation and covers the whole cyclic lattice within	*/
+/* a few words, so every cell has to be stepped all the same.  It is	*/
+/* also an independent formulation of the stream, which rule30.verify.c	*/
+/* checks the lattice engines against.  CONE_GENS may be 2 (4 kB step	*/
+/* table, always in L1) or 4 (64 kB).					*/
+/************************************************************************/
+
+#ifndef RULE30_CONE_H
+#define RULE30_CONE_H
+
+#include "rule30.rng.h"
+
+#ifndef CONE_GENS
+#define CONE_GENS	4		/* generations per lookup, 2 or 4 */
+#endif
+#if (CONE_GENS != 2) && (CONE_GENS != 4)
+#error CONE_GENS must be 2 or 4
+#endif
+
+#define CONE_BYTES	(RNG_REGS*WORDSIZE/8)			/* the lattice in bytes */
+#define CONE_STEP_BITS	(8 + 2*CONE_GENS)			/* cells in a step window */
+#define CONE_CENTER_BITS	(2*CONE_GENS + 1)		/* cells in a center window */
+#define CONE_CENTER	((RNG_REGS / 2)*WORDSIZE + (WORDSIZE - 1 - DELTA_CENTER))	/* the center cell, as in RNG_CENTER_BIT */
+#define CONE_FIRST	(CONE_CENTER - CONE_GENS)		/* first cell of the center window */
+
+/* the tables for one rule */
+struct rule30_cone {
+
+	uint8_t step[1 << CONE_STEP_BITS];
+	uint8_t center[1 << CONE_CENTER_BITS];
+
+};
+
+/* one generation of a row of len cells, leftmost in the high bit - the row loses a cell	*/
+/* at either end, which the light cone of the cells outside it would need		*/
+static inline unsigned int rule30_cone_generation(unsigned long int rule, unsigned int row, int len) {
+
+	unsigned int next = 0;
+	int i;
+
+	for(i = 0; i < len - 2; i++)
+		next |= ((rule >> ((row >> (len - 3 - i)) & CELL_MASK)) & RHS_ONE) << (len - 3 - i);
+
+	return(next);
+
+}
+
+/* build the tables for a rule */
+static inline void rule30_cone_init(struct rule30_cone *cone, unsigned long int rule) {
+
+	unsigned int window, row, bits;
+	int g, len;
+
+	for(window = 0; window < (1U << CONE_STEP_BITS); window++) {
+		row = window;
+		for(len = CONE_STEP_BITS; len > 8; len -= 2)
+			row = rule30_cone_generation(rule, row, len);
+		cone->step[window] = row;
+	}
+
+	/* the center bits first generation first, in the high bit as in rule30_rng_fill_u64() */
+	for(window = 0; window < (1U << CONE_CENTER_BITS); window++) {
+		row = window;
+		bits = 0;
+		for(g = 0, len = CONE_CENTER_BITS; g < CONE_GENS; g++, len -= 2) {
+			row = rule30_cone_generation(rule, row, len);
+			bits = (bits << 1) | ((row >> ((len - 2) / 2)) & 1);
+		}
+		cone->center[window] = bits;
+	}
+
+}
+
+/* bulk call - the next n 64-bit words of the stream, exactly as rule30_rng_fill_u64() */
+static inline void rule30_cone_fill_u64(const struct rule30_cone *cone, struct rule30_rng_state *state, uint64_t *buf, size_t n) {
+
+	/* the lattice a byte at a time with a byte of the other end on the left and two on	*/
+	/* the right, so that no window needs wrapping around				*/
+	uint8_t lattice[2][CONE_BYTES + 3], *cur = lattice[0], *next = lattice[1], *swap;
+	uint64_t random_result_int;
+	unsigned int window;
+	size_t i;
+	int j, b;
+
+	for(b = 0; b < CONE_BYTES; b++)
+		cur[b + 1] = state->reg[b / (WORDSIZE/8)] >> (WORDSIZE - 8 - 8*(b % (WORDSIZE/8)));
+
+	for(i = 0; i < n; i++) {
+
+		random_result_int = 0;
+		for(j = 0; j < 64; j += CONE_GENS) {
+
+			cur[0] = cur[CONE_BYTES];
+			cur[CONE_BYTES + 1] = cur[1];
+			cur[CONE_BYTES + 2] = cur[2];
+
+			/* the next CONE_GENS center bits from the light cone of the center cell */
+			window = ((unsigned int)cur[CONE_FIRST/8 + 1] << 16) | ((unsigned int)cur[CONE_FIRST/8 + 2] << 8) | cur[CONE_FIRST/8 + 3];
+			window = (window >> (24 - CONE_FIRST % 8 - CONE_CENTER_BITS)) & ((1U << CONE_CENTER_BITS) - 1);
+			random_result_int = (random_result_int << CONE_GENS) | cone->center[window];
+
+			/* and the whole lattice CONE_GENS generations on */
+			for(b = 1; b <= CONE_BYTES; b++) {
+				memcpy(&window, cur + b - 1, sizeof(window));
+				next[b] = cone->step[(__builtin_bswap32(window) >> (16 - CONE_GENS)) & ((1U << CONE_STEP_BITS) - 1)];
+			}
+
+			swap = cur;
+			cur = next;
+			next = swap;
+
+		}
+		*(buf + i) = random_result_int;
+
+	}
+
+	for(b = 0; b < RNG_REGS; b++)
+		state->reg[b] = 0;
+	for(b = 0; b < CONE_BYTES; b++)
+		state->reg[b / (WORDSIZE/8)] |= (unsigned long int)cur[b + 1] << (WORDSIZE - 8 - 8*(b % (WORDSIZE/8)));
+
+}
+
+#endif /* RULE30_CONE_H */
@@ -0,0 +1,498 @@
+/************************************************************************/
+/* XR30256, a toy block cipher on the rule 30 cellular automaton	*/
+/*									*/
+/* The cipher itself - a 16 round Feistel network whose F-function is	*/
+/* CA256, 4 iterations of rule 30 on a 256-bit cyclic lattice - kept in	*/
+/* a header so that it can be included into other codes, e.g. the	*/
+/* benchmark suite.  See rule30.crypt.c for the description and the	*/
+/* caveats: this is a research curiosity, not a secure cipher.		*/
+/*									*/
+/*	xr30256_key_schedule()		schedule a 256-bit key		*/
+/*	xr30256_encrypt()		encrypt one 256-bit block	*/
+/*	xr30256_decrypt()		decrypt one 256-bit block	*/
+/*									*/
+/* @2005 Jonathan Belof							*/
+/************************************************************************/
+
+#ifndef RULE30_CRYPT_H
+#define RULE30_CRYPT_H
+
+#include <sys/types.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "ca.h"
+#include "ca.dispatch.h"
+#include "ca.stats.h"
+
+/* the register array is of 64-bit words */
+#define WORDSIZE	64
+
+/* 64-bit masks */
+#define RULE30		0x000000000000001E	/* 0000000000000000000000000000000000000000000000000000000000011110 */
+#define RULE110		0x000000000000006E	/* 0000000000000000000000000000000000000000000000000000000001101110 */
+#define RULE10		0x000000000000000A	/* 0000000000000000000000000000000000000000000000000000000000001010 */
+#define RULE90		0x000000000000005A	/* 0000000000000000000000000000000000000000000000000000000001011010 */
+
+#define CELL_MASK	0x0000000000000007	/* 0000000000000000000000000000000000000000000000000000000000000111 */
+#define RHS_ONE		0x0000000000000001	/* 0000000000000000000000000000000000000000000000000000000000000001 */
+#define LHS_ONE		0x8000000000000000	/* 1000000000000000000000000000000000000000000000000000000000000000 */
+#define LHS_ZERO	0x7FFFFFFFFFFFFFFF	/* 0111111111111111111111111111111111111111111111111111111111111111 */
+#define INNER_COUNT	0x00000000000000FF	/* 0000000000000000000000000000000000000000000000000000000011111111 */
+#define INNER_ONE	0x0000000000000001	/* 0000000000000000000000000000000000000000000000000000000000000001 */
+#define INNER_ZERO	0xFFFFFFFFFFFFFF00	/* 1111111111111111111111111111111111111111111111111111111100000000 */
+#define OUTER_COUNT	0x0000000000FFFF00	/* 0000000000000000000000000000000000000000111111111111111100000000 */
+#define OUTER_ONE	0x0000000000000100	/* 0000000000000000000000000000000000000001000000000000000000000000 */
+#define OUTER_ZERO	0xFFFFFFFFFF0000FF	/* 1111111111111111111111111111111111111111000000000000000011111111 */
+#define DELTA_COUNT	0x0000000000000008	/* 0000000000000000000000000000000000000000000000000000000000001000 */
+#define DELTA_ROUNDS	0x0000000000000018	/* 0000000000000000000000000000000000000000000000000000000000011000 */
+#define ROUNDS_COUNT	0x000000FFFF000000	/* 0000000000000000000000001111111111111111000000000000000000000000 */
+#define ROUNDS_ZERO	0xFFFFFF0000FFFFFF	/* 1111111111111111111111110000000000000000111111111111111111111111 */
+#define ROUNDS_ONE	0x0000000001000000	/* 0000000000000000000000000000000000000001000000000000000000000000 */
+#define CA256		0x00000000000000FF	/* 0000000000000000000000000000000000000000000000000000000011111111 */
+#define ROUNDS		0x0000000000000010	/* 0000000000000000000000000000000000000000000000000000000000010000 */
+
+/* the 256-bit lattice that CA256 runs on */
+CA_LATTICE_DEFINE(ca256_lattice, unsigned long int, 256 / WORDSIZE, WORDSIZE)
+
+struct scheduled_key {
+
+	unsigned long int key_1[4];
+	unsigned long int key_2[4];
+	unsigned long int key_3[4];
+	unsigned long int key_4[4];
+
+};
+
+#ifdef DEBUG
+void print_binary(unsigned long int in);
+#endif /* DEBUG */
+
+static inline struct scheduled_key * xr30256_key_schedule(unsigned long int *key) {
+
+	struct scheduled_key *skey;			/* the scheduled key segments */
+	register unsigned long int rule = RULE30;	/* the rule to enforce */
+	ca256_lattice key_reg = { { 0 } };		/* key registers */
+	register unsigned long int mp = 0;		/* multi-purpose register:					*/
+							/* 	- bits 8 through 23 are for the generation counter	*/
+
+	CA_STATS_START(stats_start);
+
+	/* allocate space for the key segments that have been scheduled through the CA state machine */
+	skey = calloc(1, sizeof(struct scheduled_key));
+
+	/* load the 1st key segment */
+	key_reg.reg[0] = *(key + 0);
+	key_reg.reg[1] = *(key + 0) + (*(key + 0))*(*(key + 1));
+	key_reg.reg[2] = *(key + 0) + (*(key + 0))*(*(key + 2));
+	key_reg.reg[3] = *(key + 0) + (*(key + 0))*(*(key + 3));
+
+	/* K1/CA256 */
+	for((mp &= OUTER_ZERO); ((mp & OUTER_COUNT) >> DELTA_COUNT) < CA256; mp += OUTER_ONE)
+		ca256_lattice_step(&key_reg, rule);
+
+	skey->key_1[0] = key_reg.reg[0];
+	skey->key_1[1] = key_reg.reg[1];
+	skey->key_1[2] = key_reg.reg[2];
+	skey->key_1[3] = key_reg.reg[3];
+
+#ifdef DEBUG
+	printf("K1:\n");
+	print_binary(skey->key_1[0]); print_binary(skey->key_1[1]); print_binary(skey->key_1[2]); print_binary(skey->key_1[3]); printf("\n");
+#endif /* DEBUG */
+
+	/* load the 2nd key segment */
+	key_reg.reg[0] = *(key + 1) + (*(key + 1))*(*(key + 0));
+	key_reg.reg[1] = *(key + 1);
+	key_reg.reg[2] = *(key + 1) + (*(key + 1))*(*(key + 2));
+	key_reg.reg[3] = *(key + 1) + (*(key + 1))*(*(key + 3));
+
+	/* K2/CA256 */
+	for((mp &= OUTER_ZERO); ((mp & OUTER_COUNT) >> DELTA_COUNT) < CA256; mp += OUTER_ONE)
+		ca256_lattice_step(&key_reg, rule);
+
+	skey->key_2[0] = key_reg.reg[0];
+	skey->key_2[1] = key_reg.reg[1];
+	skey->key_2[2] = key_reg.reg[2];
+	skey->key_2[3] = key_reg.reg[3];
+
+#ifdef DEBUG
+	printf("K2:\n");
+	print_binary(skey->key_2[0]); print_binary(skey->key_2[1]); print_binary(skey->key_2[2]); print_binary(skey->key_2[3]); printf("\n");
+#endif /* DEBUG */
+
+	/* load the 3rd key segment */
+	key_reg.reg[0] = *(key + 2) + (*(key + 2))*(*(key + 0));
+	key_reg.reg[1] = *(key + 2) + (*(key + 2))*(*(key + 1));
+	key_reg.reg[2] = *(key + 2);
+	key_reg.reg[3] = *(key + 2) + (*(key + 2))*(*(key + 3));
+
+	/* K3/CA256 */
+	for((mp &= OUTER_ZERO); ((mp & OUTER_COUNT) >> DELTA_COUNT) < CA256; mp += OUTER_ONE)
+		ca256_lattice_step(&key_reg, rule);
+
+	skey->key_3[0] = key_reg.reg[0];
+	skey->key_3[1] = key_reg.reg[1];
+	skey->key_3[2] = key_reg.reg[2];
+	skey->key_3[3] = key_reg.reg[3];
+
+#ifdef DEBUG
+	printf("K3:\n");
+	print_binary(skey->key_3[0]); print_binary(skey->key_3[1]); print_binary(skey->key_3[2]); print_binary(skey->key_3[3]); printf("\n");
+#endif /* DEBUG */
+
+	/* load the 4th key segment */
+	key_reg.reg[0] = *(key + 3) + (*(key + 3))*(*(key + 0));
+	key_reg.reg[1] = *(key + 3) + (*(key + 3))*(*(key + 1));
+	key_reg.reg[2] = *(key + 3) + (*(key + 3))*(*(key + 2));
+	key_reg.reg[3] = *(key + 3);
+
+	/* K4/CA256 */
+	for((mp &= OUTER_ZERO); ((mp & OUTER_COUNT) >> DELTA_COUNT) < CA256; mp += OUTER_ONE)
+		ca256_lattice_step(&key_reg, rule);
+
+	skey->key_4[0] = key_reg.reg[0];
+	skey->key_4[1] = key_reg.reg[1];
+	skey->key_4[2] = key_reg.reg[2];
+	skey->key_4[3] = key_reg.reg[3];
+
+#ifdef DEBUG
+	printf("K4:\n");
+	print_binary(skey->key_4[0]); print_binary(skey->key_4[1]); print_binary(skey->key_4[2]); print_binary(skey->key_4[3]); printf("\n");
+#endif /* DEBUG */
+
+	CA_STATS_END(CA_PHASE_SCHEDULE, stats_start, 4*CA256, 0);
+	return(skey);
+
+}
+
+
+static inline void xr30256_encrypt(struct scheduled_key *key, unsigned long int *plaintext, unsigned long int *ciphertext) {
+
+	register unsigned long int rule = RULE30;	/* the rule to enforce */
+	ca256_lattice key_reg = { { 0 } };		/* key registers */
+	register unsigned long int plain_1 = 0,
+				   plain_2 = 0,
+				   plain_3 = 0,
+				   plain_4 = 0;
+	register unsigned long int mp = 0;		/* multi-purpose register:					*/
+							/* 	- bits 8 through 23 are for the generation counter	*/
+							/*	- the next 16 bits are for the rounds counter		*/
+
+	CA_STATS_START(stats_start);
+
+	/* load the plaintext */
+	plain_1 = *(plaintext + 0);
+	plain_2 = *(plaintext + 1);
+	plain_3 = *(plaintext + 2);
+	plain_4 = *(plaintext + 3);
+
+	/* initialize with the right-half */
+	key_reg.reg[0] ^= plain_3;
+	key_reg.reg[1] ^= plain_4;
+	key_reg.reg[2] = key_reg.reg[0];
+	key_reg.reg[3] = key_reg.reg[1];
+
+	for(mp &= ROUNDS_ZERO; ((mp & ROUNDS_COUNT) >> DELTA_ROUNDS) < ROUNDS; mp += ROUNDS_ONE) {
+
+		/****************************/
+		/***** START F-function *****/
+		/****************************/
+		/* load the first scheduled subkey */
+		key_reg.reg[0] ^= key->key_1[0];
+		key_reg.reg[1] ^= key->key_1[1];
+		key_reg.reg[2] ^= key->key_1[2];
+		key_reg.reg[3] ^= key->key_1[3];
+
+		/* K1/CA256 */
+		for((mp &= OUTER_ZERO); ((mp & OUTER_COUNT) >> DELTA_COUNT) < CA256; mp += OUTER_ONE)
+			ca256_lattice_step(&key_reg, rule);
+
+		/* XOR right and left half together and replicate result in both key halves */
+		key_reg.reg[0] ^= key_reg.reg[2];
+		key_reg.reg[1] ^= key_reg.reg[3];
+		key_reg.reg[2] = key_reg.reg[0];
+		key_reg.reg[3] = key_reg.reg[1];
+		/**************************/
+		/***** END F-function *****/
+		/**************************/
+
+		/* Feistel XOR with left-half */
+		key_reg.reg[0] ^= plain_1;
+		key_reg.reg[1] ^= plain_2;
+		key_reg.reg[2] = key_reg.reg[0];
+		key_reg.reg[3] = key_reg.reg[1];
+		plain_1 = key_reg.reg[0];
+		plain_2 = key_reg.reg[1];
+
+		/****************************/
+		/***** START F-function *****/
+		/****************************/
+		/* load the second scheduled subkey */
+		key_reg.reg[0] ^= key->key_2[0];
+		key_reg.reg[1] ^= key->key_2[1];
+		key_reg.reg[2] ^= key->key_2[2];
+		key_reg.reg[3] ^= key->key_2[3];
+
+		/* K2/CA256 */
+		for((mp &= OUTER_ZERO); ((mp & OUTER_COUNT) >> DELTA_COUNT) < CA256; mp += OUTER_ONE)
+			ca256_lattice_step(&key_reg, rule);
+		/* XOR right and left half together and replicate result in both key halves */
+		key_reg.reg[0] ^= key_reg.reg[2];
+		key_reg.reg[1] ^= key_reg.reg[3];
+		key_reg.reg[2] = key_reg.reg[0];
+		key_reg.reg[3] = key_reg.reg[1];
+		/**************************/
+		/***** END F-function *****/
+		/**************************/
+
+		/* Feistel XOR with right-half */
+		key_reg.reg[0] ^= plain_3;
+		key_reg.reg[1] ^= plain_4;
+		key_reg.reg[2] = key_reg.reg[0];
+		key_reg.reg[3] = key_reg.reg[1];
+		plain_3 = key_reg.reg[0];
+		plain_4 = key_reg.reg[1];
+
+		/****************************/
+		/***** START F-function *****/
+		/****************************/
+		/* load the third scheduled subkey */
+		key_reg.reg[0] ^= key->key_3[0];
+		key_reg.reg[1] ^= key->key_3[1];
+		key_reg.reg[2] ^= key->key_3[2];
+		key_reg.reg[3] ^= key->key_3[3];
+
+		/* K3/CA256 */
+		for((mp &= OUTER_ZERO); ((mp & OUTER_COUNT) >> DELTA_COUNT) < CA256; mp += OUTER_ONE)
+			ca256_lattice_step(&key_reg, rule);
+		/* XOR right and left half together and replicate result in both key halves */
+		key_reg.reg[0] ^= key_reg.reg[2];
+		key_reg.reg[1] ^= key_reg.reg[3];
+		key_reg.reg[2] = key_reg.reg[0];
+		key_reg.reg[3] = key_reg.reg[1];
+		/**************************/
+		/***** END F-function *****/
+		/**************************/
+
+		/* Feistel XOR with left-half */
+		key_reg.reg[0] ^= plain_1;
+		key_reg.reg[1] ^= plain_2;
+		key_reg.reg[2] = key_reg.reg[0];
+		key_reg.reg[3] = key_reg.reg[1];
+		plain_1 = key_reg.reg[0];
+		plain_2 = key_reg.reg[1];
+
+
+		/****************************/
+		/***** START F-function *****/
+		/****************************/
+		/* load the fourth scheduled subkey */
+		key_reg.reg[0] ^= key->key_4[0];
+		key_reg.reg[1] ^= key->key_4[1];
+		key_reg.reg[2] ^= key->key_4[2];
+		key_reg.reg[3] ^= key->key_4[3];
+
+		/* K4/CA256 */
+		for((mp &= OUTER_ZERO); ((mp & OUTER_COUNT) >> DELTA_COUNT) < CA256; mp += OUTER_ONE)
+			ca256_lattice_step(&key_reg, rule);
+		/* XOR right and left half together and replicate result in both key halves */
+		key_reg.reg[0] ^= key_reg.reg[2];
+		key_reg.reg[1] ^= key_reg.reg[3];
+		key_reg.reg[2] = key_reg.reg[0];
+		key_reg.reg[3] = key_reg.reg[1];
+		/**************************/
+		/***** END F-function *****/
+		/**************************/
+
+		/* Feistel XOR with left-half */
+		key_reg.reg[0] ^= plain_3;
+		key_reg.reg[1] ^= plain_4;
+		key_reg.reg[2] = key_reg.reg[0];
+		key_reg.reg[3] = key_reg.reg[1];
+		plain_3 = key_reg.reg[0];
+		plain_4 = key_reg.reg[1];
+
+
+	}
+
+	/* store the resulting ciphertext */
+	*(ciphertext + 0) = plain_3;
+	*(ciphertext + 1) = plain_4;
+	*(ciphertext + 2) = plain_1;
+	*(ciphertext + 3) = plain_2;
+
+	CA_STATS_END(CA_PHASE_ENCRYPT, stats_start, ROUNDS*4*CA256, 0);
+
+}
+
+
+static inline void xr30256_decrypt(struct scheduled_key *key, unsigned long int *ciphertext, unsigned long int *plaintext) {
+
+	register unsigned long int rule = RULE30;	/* the rule to enforce */
+	ca256_lattice key_reg = { { 0 } };		/* key registers */
+	register unsigned long int cipher_1 = 0,
+				   cipher_2 = 0,
+				   cipher_3 = 0,
+				   cipher_4 = 0;
+	register unsigned long int mp = 0;		/* multi-purpose register:					*/
+							/* 	- bits 8 through 23 are for the generation counter	*/
+							/*	- the next 16 bits are for the rounds counter		*/
+
+	CA_STATS_START(stats_start);
+
+	/* load the ciphertext */
+	cipher_1 = *(ciphertext + 0);
+	cipher_2 = *(ciphertext + 1);
+	cipher_3 = *(ciphertext + 2);
+	cipher_4 = *(ciphertext + 3);
+
+	/* initialize with the right-half */
+	key_reg.reg[0] ^= cipher_3;
+	key_reg.reg[1] ^= cipher_4;
+	key_reg.reg[2] = key_reg.reg[0];
+	key_reg.reg[3] = key_reg.reg[1];
+
+	for(mp &= ROUNDS_ZERO; ((mp & ROUNDS_COUNT) >> DELTA_ROUNDS) < ROUNDS; mp += ROUNDS_ONE) {
+
+		/****************************/
+		/***** START F-function *****/
+		/****************************/
+		/* load the fourth scheduled subkey */
+		key_reg.reg[0] ^= key->key_4[0];
+		key_reg.reg[1] ^= key->key_4[1];
+		key_reg.reg[2] ^= key->key_4[2];
+		key_reg.reg[3] ^= key->key_4[3];
+
+		/* K4/CA256 */
+		for((mp &= OUTER_ZERO); ((mp & OUTER_COUNT) >> DELTA_COUNT) < CA256; mp += OUTER_ONE)
+			ca256_lattice_step(&key_reg, rule);
+
+		/* XOR right and left half together and replicate result in both key halves */
+		key_reg.reg[0] ^= key_reg.reg[2];
+		key_reg.reg[1] ^= key_reg.reg[3];
+		key_reg.reg[2] = key_reg.reg[0];
+		key_reg.reg[3] = key_reg.reg[1];
+		/**************************/
+		/***** END F-function *****/
+		/**************************/
+
+		/* Feistel XOR with left-half */
+		key_reg.reg[0] ^= cipher_1;
+		key_reg.reg[1] ^= cipher_2;
+		key_reg.reg[2] = key_reg.reg[0];
+		key_reg.reg[3] = key_reg.reg[1];
+		cipher_1 = key_reg.reg[0];
+		cipher_2 = key_reg.reg[1];
+
+		/****************************/
+		/***** START F-function *****/
+		/****************************/
+		/* load the third scheduled subkey */
+		key_reg.reg[0] ^= key->key_3[0];
+		key_reg.reg[1] ^= key->key_3[1];
+		key_reg.reg[2] ^= key->key_3[2];
+		key_reg.reg[3] ^= key->key_3[3];
+
+		/* K3/CA256 */
+		for((mp &= OUTER_ZERO); ((mp & OUTER_COUNT) >> DELTA_COUNT) < CA256; mp += OUTER_ONE)
+			ca256_lattice_step(&key_reg, rule);
+		/* XOR right and left half together and replicate result in both key halves */
+		key_reg.reg[0] ^= key_reg.reg[2];
+		key_reg.reg[1] ^= key_reg.reg[3];
+		key_reg.reg[2] = key_reg.reg[0];
+		key_reg.reg[3] = key_reg.reg[1];
+		/**************************/
+		/***** END F-function *****/
+		/**************************/
+
+		/* Feistel XOR with right-half */
+		key_reg.reg[0] ^= cipher_3;
+		key_reg.reg[1] ^= cipher_4;
+		key_reg.reg[2] = key_reg.reg[0];
+		key_reg.reg[3] = key_reg.reg[1];
+		cipher_3 = key_reg.reg[0];
+		cipher_4 = key_reg.reg[1];
+
+
+		/****************************/
+		/***** START F-function *****/
+		/****************************/
+		/* load the second scheduled subkey */
+		key_reg.reg[0] ^= key->key_2[0];
+		key_reg.reg[1] ^= key->key_2[1];
+		key_reg.reg[2] ^= key->key_2[2];
+		key_reg.reg[3] ^= key->key_2[3];
+
+		/* K2/CA256 */
+		for((mp &= OUTER_ZERO); ((mp & OUTER_COUNT) >> DELTA_COUNT) < CA256; mp += OUTER_ONE)
+			ca256_lattice_step(&key_reg, rule);
+		/* XOR right and left half together and replicate result in both key halves */
+		key_reg.reg[0] ^= key_reg.reg[2];
+		key_reg.reg[1] ^= key_reg.reg[3];
+		key_reg.reg[2] = key_reg.reg[0];
+		key_reg.reg[3] = key_reg.reg[1];
+		/**************************/
+		/***** END F-function *****/
+		/**************************/
+
+		/* Feistel XOR with left-half */
+		key_reg.reg[0] ^= cipher_1;
+		key_reg.reg[1] ^= cipher_2;
+		key_reg.reg[2] = key_reg.reg[0];
+		key_reg.reg[3] = key_reg.reg[1];
+		cipher_1 = key_reg.reg[0];
+		cipher_2 = key_reg.reg[1];
+
+
+		/****************************/
+		/***** START F-function *****/
+		/****************************/
+		/* load the first scheduled subkey */
+		key_reg.reg[0] ^= key->key_1[0];
+		key_reg.reg[1] ^= key->key_1[1];
+		key_reg.reg[2] ^= key->key_1[2];
+		key_reg.reg[3] ^= key->key_1[3];
+
+		/* K1/CA256 */
+		for((mp &= OUTER_ZERO); ((mp & OUTER_COUNT) >> DELTA_COUNT) < CA256; mp += OUTER_ONE)
+			ca256_lattice_step(&key_reg, rule);
+		/* XOR right and left half together and replicate result in both key halves */
+		key_reg.reg[0] ^= key_reg.reg[2];
+		key_reg.reg[1] ^= key_reg.reg[3];
+		key_reg.reg[2] = key_reg.reg[0];
+		key_reg.reg[3] = key_reg.reg[1];
+		/**************************/
+		/***** END F-function *****/
+		/**************************/
+
+		/* Feistel XOR with left-half */
+		key_reg.reg[0] ^= cipher_3;
+		key_reg.reg[1] ^= cipher_4;
+		key_reg.reg[2] = key_reg.reg[0];
+		key_reg.reg[3] = key_reg.reg[1];
+		cipher_3 = key_reg.reg[0];
+		cipher_4 = key_reg.reg[1];
+
+
+	}
+
+	/* store the resulting ciphertext */
+	*(plaintext + 0) = cipher_3;
+	*(plaintext + 1) = cipher_4;
+	*(plaintext + 2) = cipher_1;
+	*(plaintext + 3) = cipher_2;
+
+	CA_STATS_END(CA_PHASE_DECRYPT, stats_start, ROUNDS*4*CA256, 0);
+
+}
+
+/* the cipher with its CA256 F-function compiled for each instruction set, the best one	*/
+/* for the CPU chosen at startup - see ca.dispatch.h					*/
+CA_DISPATCH_DEFINE(xr30256_encrypt_dispatch, xr30256_encrypt,
+		   (struct scheduled_key *key, unsigned long int *plaintext, unsigned long int *ciphertext), (key, plaintext, ciphertext))
+CA_DISPATCH_DEFINE(xr30256_decrypt_dispatch, xr30256_decrypt,
+		   (struct scheduled_key *key, unsigned long int *ciphertext, unsigned long int *plaintext), (key, ciphertext, plaintext))
+
+
+#endif /* RULE30_CRYPT_H */
@@ -0,0 +1,123 @@
+/************************************************************************/
+/* Counter-based (random access) rule 30 generator			*/
+/*									*/
+/* In the style of Philox/Threefry: there is no state to carry from one	*/
+/* number to the next, output block i is a pure function of a key and	*/
+/* the counter i,							*/
+/*									*/
+/*		block(i) = CA^k(key XOR i)				*/
+/*									*/
+/* on a 256-cell cyclic lattice (4 registers of 64 cells).  The counter	*/
+/* is spread over every register (multiplied by a different odd		*/
+/* constant for each, so distinct counters always give distinct		*/
+/* lattices), the lattice is run CTR_WARMUP generations so that every	*/
+/* cell depends on every counter bit, and then the center cell of each	*/
+/* register is harvested for 64 more generations, giving CTR_WORDS	*/
+/* 64-bit words per block.						*/
+/*									*/
+/* Any thread or node can thus compute output word n directly with	*/
+/* rule30_ctr_fill_u64(key, n, buf, count), without warming up a stream	*/
+/* or sharing any state, and a run gives the same numbers however the	*/
+/* counter space is divided among the workers.				*/
+/*									*/
+/*	rule30_ctr_init()		derive a key from a seed	*/
+/*	rule30_ctr_block()		block i, CTR_WORDS words	*/
+/*	rule30_ctr_fill_u64()		words first..first+n-1		*/
+/************************************************************************/
+
+#ifndef RULE30_CTR_H
+#define RULE30_CTR_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "rule30.rng.h"
+
+#define CTR_REGS	4		/* registers in the circular array, 256 cells */
+#define CTR_WORDS	CTR_REGS	/* 64-bit words per block, one per register */
+#define CTR_WARMUP	128		/* generations before harvesting - twice a register */
+#define CTR_CENTER	32		/* the harvested cell of each register */
+
+CA_LATTICE_DEFINE(ctr_lattice, uint64_t, CTR_REGS, 64)
+
+/* the key - read only once set up, so one key may be shared by any number of threads */
+struct rule30_ctr_key {
+
+	uint64_t reg[CTR_REGS];
+
+};
+
+/* odd multipliers spreading the counter over the registers */
+static const uint64_t rule30_ctr_spread[CTR_REGS] = {
+
+	0x9E3779B97F4A7C15ULL, 0xBF58476D1CE4E5B9ULL, 0x94D049BB133111EBULL, 0xD6E8FEB86659FD93ULL
+
+};
+
+/* derive the key lattice from a seed, a splitmix64 word per register */
+static inline void rule30_ctr_init(struct rule30_ctr_key *key, uint64_t seed) {
+
+	uint64_t z = seed, x;
+	int i;
+
+	for(i = 0; i < CTR_REGS; i++) {
+		z += 0x9E3779B97F4A7C15ULL;
+		x = z;
+		x = (x ^ (x >> 30))*0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27))*0x94D049BB133111EBULL;
+		key->reg[i] = x ^ (x >> 31);
+	}
+
+}
+
+/* compute block i of the key's output */
+static inline void rule30_ctr_block(const struct rule30_ctr_key *key, uint64_t counter, uint64_t *out) {
+
+	register unsigned long int rule = RULE30;	/* the rule to enforce */
+	ctr_lattice lattice;
+	uint64_t random_result_int[CTR_WORDS] = { 0 };
+	int i, j;
+
+	/* key XOR counter */
+	for(i = 0; i < CTR_REGS; i++)
+		lattice.reg[i] = key->reg[i] ^ (counter*rule30_ctr_spread[i]);
+
+	for(j = 0; j < CTR_WARMUP; j++)
+		ctr_lattice_step(&lattice, rule);
+
+	for(j = 0; j < 64; j++) {
+		ctr_lattice_step(&lattice, rule);
+		for(i = 0; i < CTR_REGS; i++)
+			random_result_int[i] = (random_result_int[i] << 1) | ((lattice.reg[i] >> CTR_CENTER) & 1);
+	}
+
+	memcpy(out, random_result_int, sizeof(random_result_int));
+
+}
+
+/* fill buf with output words first..first+n-1 - word w is word w % CTR_WORDS of block	*/
+/* w / CTR_WORDS, so any slice of the output can be computed independently		*/
+static inline void rule30_ctr_fill_u64(const struct rule30_ctr_key *key, uint64_t first, uint64_t *buf, size_t n) {
+
+	uint64_t block[CTR_WORDS];
+	uint64_t counter = first / CTR_WORDS;
+	size_t skip = first % CTR_WORDS, count;
+
+	while(n) {
+
+		rule30_ctr_block(key, counter++, block);
+
+		count = CTR_WORDS - skip;
+		if(count > n)
+			count = n;
+		memcpy(buf, block + skip, count*sizeof(uint64_t));
+
+		buf += count;
+		n -= count;
+		skip = 0;
+
+	}
+
+}
+
+#endif /* RULE30_CTR_H */
@@ -0,0 +1,368 @@
+/************************************************************************/
+/* Distributions from the rule 30 generator				*/
+/*									*/
+/* Bulk conversions of the raw 64-bit stream into the types samplers	*/
+/* actually use, without going through the slow double path:		*/
+/*									*/
+/*	rule30_dist_double()		words to 53-bit doubles		*/
+/*	rule30_dist_float()		words to two floats each	*/
+/*	rule30_dist_fill_double()	doubles straight from a stream	*/
+/*	rule30_dist_fill_float()	floats straight from a stream	*/
+/*	rule30_dist_fill_bounded()	unbiased integers in [0, range)	*/
+/*	rule30_dist_fill_bounded64()	the same for 64-bit ranges	*/
+/*	rule30_dist_fill_normal()	standard normal variates	*/
+/*	rule30_dist_fill_exponential()	exponential variates, mean 1	*/
+/*									*/
+/* Doubles take the top 53 bits of a word times 2^-53 and floats the	*/
+/* top 24 bits of each 32-bit half (high half first) times 2^-24:	*/
+/* exact, never 1.0, and no divide.  Bounded integers use Lemire's	*/
+/* multiply-shift - the high half of x*range - with rejection of the	*/
+/* few x that would bias it; the rejection threshold (2^32 - range) %	*/
+/* range is computed once per call rather than per number, and rejected	*/
+/* candidates are squeezed out without a branch.  The double and float	*/
+/* loops are plain enough for the compiler to vectorize (e.g. with	*/
+/* -march=native).  The fill calls draw from rule30_rng_fill_u64() a	*/
+/* chunk of DIST_CHUNK words at a time; the converters work on words	*/
+/* from any source, e.g. the tap set or pool.				*/
+/*									*/
+/* Normal and exponential variates come from the ziggurats of Marsaglia	*/
+/* and Tsang (128 and 256 layers, tables from rule30_zig_init()).  A	*/
+/* chunk of words goes through a branch-free fast path - layer from the	*/
+/* low byte, uniform from the top bits, scaled to the layer's width -	*/
+/* and only the ~1% of words that fall outside their layer's rectangle	*/
+/* take the scalar wedge and tail code with its exp() and log(), so	*/
+/* there are almost no transcendentals per variate.  Link with -lm.	*/
+/************************************************************************/
+
+#ifndef RULE30_DIST_H
+#define RULE30_DIST_H
+
+#include <math.h>
+
+#include "rule30.rng.h"
+
+#define DIST_CHUNK	256		/* words drawn from the stream at a time */
+
+/* ziggurats of Marsaglia and Tsang, with the layer tables laid out as in Doornik's ZIGNOR */
+#define ZIG_NORMAL_LAYERS	128
+#define ZIG_NORMAL_R		3.442619855899			/* start of the tail */
+#define ZIG_NORMAL_V		9.91256303526217e-3		/* area of each layer */
+#define ZIG_EXP_LAYERS		256
+#define ZIG_EXP_R		7.69711747013104972
+#define ZIG_EXP_V		3.949659822581572e-3
+
+/* the layer tables - x[i] is the right edge of layer i and r[i] = x[i + 1]/x[i] the	*/
+/* fraction of it that lies wholly under the density					*/
+struct rule30_zig {
+
+	double normal_x[ZIG_NORMAL_LAYERS + 1];
+	double normal_r[ZIG_NORMAL_LAYERS];
+	double exp_x[ZIG_EXP_LAYERS + 1];
+	double exp_r[ZIG_EXP_LAYERS];
+
+};
+
+/* n words to n doubles in [0, 1) */
+static inline void rule30_dist_double(const uint64_t *in, double *out, size_t n) {
+
+	size_t i;
+
+	for(i = 0; i < n; i++)
+		*(out + i) = (double)(*(in + i) >> 11)*0x1.0p-53;
+
+}
+
+/* n words to 2n floats in [0, 1), the high half of each word first */
+static inline void rule30_dist_float(const uint64_t *in, float *out, size_t n) {
+
+	size_t i;
+
+	for(i = 0; i < n; i++) {
+		*(out + 2*i) = (float)(uint32_t)(*(in + i) >> 40)*0x1.0p-24f;
+		*(out + 2*i + 1) = (float)((uint32_t)*(in + i) >> 8)*0x1.0p-24f;
+	}
+
+}
+
+/* the next n doubles in [0, 1) of the stream, one word each */
+static inline void rule30_dist_fill_double(struct rule30_rng_state *state, double *buf, size_t n) {
+
+	uint64_t chunk[DIST_CHUNK];
+	size_t count;
+
+	while(n) {
+		count = (n < DIST_CHUNK) ? n : DIST_CHUNK;
+		rule30_rng_fill_u64(state, chunk, count);
+		rule30_dist_double(chunk, buf, count);
+		buf += count;
+		n -= count;
+	}
+
+}
+
+/* the next n floats in [0, 1) of the stream, two per word - the last half word is	*/
+/* dropped when n is odd									*/
+static inline void rule30_dist_fill_float(struct rule30_rng_state *state, float *buf, size_t n) {
+
+	uint64_t chunk[DIST_CHUNK];
+	float last[2];
+	size_t count;
+
+	while(n > 1) {
+		count = (n/2 < DIST_CHUNK) ? n/2 : DIST_CHUNK;
+		rule30_rng_fill_u64(state, chunk, count);
+		rule30_dist_float(chunk, buf, count);
+		buf += 2*count;
+		n -= 2*count;
+	}
+	if(n) {
+		rule30_rng_fill_u64(state, chunk, 1);
+		rule30_dist_float(chunk, last, 1);
+		*buf = last[0];
+	}
+
+}
+
+/* the next n integers uniform on [0, range) of the stream, range > 0, from the 32-bit	*/
+/* halves of the words (high half first)							*/
+static inline void rule30_dist_fill_bounded(struct rule30_rng_state *state, uint32_t range, uint32_t *buf, size_t n) {
+
+	uint64_t chunk[DIST_CHUNK];
+	uint64_t product;
+	uint32_t threshold = (uint32_t)(-range) % range;	/* 2^32 mod range candidates are rejected */
+	size_t count, i, k = 0;
+
+	while(k < n) {
+
+		/* enough words for the numbers still missing, assuming nothing is rejected */
+		count = (n - k + 1)/2;
+		if(count > DIST_CHUNK)
+			count = DIST_CHUNK;
+		rule30_rng_fill_u64(state, chunk, count);
+
+		/* always store, only advance past an accepted candidate - buf has room for the	*/
+		/* store as long as k < n, hence the check before the low half			*/
+		for(i = 0; (i < count) && (k < n); i++) {
+			product = (*(chunk + i) >> 32)*(uint64_t)range;
+			*(buf + k) = product >> 32;
+			k += ((uint32_t)product >= threshold);
+			if(k < n) {
+				product = (*(chunk + i) & 0xFFFFFFFFULL)*(uint64_t)range;
+				*(buf + k) = product >> 32;
+				k += ((uint32_t)product >= threshold);
+			}
+		}
+
+	}
+
+}
+
+/* the next n integers uniform on [0, range) of the stream, range > 0, a word each */
+static inline void rule30_dist_fill_bounded64(struct rule30_rng_state *state, uint64_t range, uint64_t *buf, size_t n) {
+
+	uint64_t chunk[DIST_CHUNK];
+	unsigned __int128 product;
+	uint64_t threshold = (-range) % range;			/* 2^64 mod range candidates are rejected */
+	size_t count, i, k = 0;
+
+	while(k < n) {
+
+		count = n - k;
+		if(count > DIST_CHUNK)
+			count = DIST_CHUNK;
+		rule30_rng_fill_u64(state, chunk, count);
+
+		for(i = 0; (i < count) && (k < n); i++) {
+			product = (unsigned __int128)*(chunk + i)*range;
+			*(buf + k) = product >> 64;
+			k += ((uint64_t)product >= threshold);
+		}
+
+	}
+
+}
+
+/* build the ziggurat tables, once - they are read only afterwards and may be shared */
+static inline void rule30_zig_init(struct rule30_zig *zig) {
+
+	double f;
+	int i;
+
+	f = exp(-0.5*ZIG_NORMAL_R*ZIG_NORMAL_R);
+	zig->normal_x[0] = ZIG_NORMAL_V/f;		/* the base strip, with the tail folded in */
+	zig->normal_x[1] = ZIG_NORMAL_R;
+	zig->normal_x[ZIG_NORMAL_LAYERS] = 0;
+	for(i = 2; i < ZIG_NORMAL_LAYERS; i++) {
+		zig->normal_x[i] = sqrt(-2.0*log(ZIG_NORMAL_V/zig->normal_x[i - 1] + f));
+		f = exp(-0.5*zig->normal_x[i]*zig->normal_x[i]);
+	}
+	for(i = 0; i < ZIG_NORMAL_LAYERS; i++)
+		zig->normal_r[i] = zig->normal_x[i + 1]/zig->normal_x[i];
+
+	f = exp(-ZIG_EXP_R);
+	zig->exp_x[0] = ZIG_EXP_V/f;
+	zig->exp_x[1] = ZIG_EXP_R;
+	zig->exp_x[ZIG_EXP_LAYERS] = 0;
+	for(i = 2; i < ZIG_EXP_LAYERS; i++) {
+		zig->exp_x[i] = -log(ZIG_EXP_V/zig->exp_x[i - 1] + f);
+		f = exp(-zig->exp_x[i]);
+	}
+	for(i = 0; i < ZIG_EXP_LAYERS; i++)
+		zig->exp_r[i] = zig->exp_x[i + 1]/zig->exp_x[i];
+
+}
+
+/* one more word of the stream, for the slow paths */
+static inline uint64_t rule30_dist_word(struct rule30_rng_state *state) {
+
+	uint64_t word;
+
+	rule30_rng_fill_u64(state, &word, 1);
+	return(word);
+
+}
+
+/* the uniforms of a word - the layer is taken from the low byte and the uniform from	*/
+/* the top 52 bits, so the two are independent						*/
+#define ZIG_UNIFORM(word)		RNG_MANTISSA_DOUBLE((word) >> 12)		/* [0, 1) */
+#define ZIG_SIGNED_UNIFORM(word)	(2.0*ZIG_UNIFORM(word) - 1.0)			/* [-1, 1) */
+#define ZIG_OPEN_UNIFORM(word)		(1.0 - (double)((word) >> 11)*0x1.0p-53)	/* (0, 1] for the logarithms */
+
+/* the normal ziggurat from a word that missed the rectangle of its layer - the wedge	*/
+/* and tail tests, drawing further words until a variate is accepted			*/
+static inline double rule30_zig_normal_slow(struct rule30_rng_state *state, const struct rule30_zig *zig, uint64_t word) {
+
+	double u, x, y, f0, f1;
+	int i;
+
+	while(1) {
+
+		i = word & (ZIG_NORMAL_LAYERS - 1);
+		u = ZIG_SIGNED_UNIFORM(word);
+
+		if(fabs(u) < zig->normal_r[i])
+			return(u*zig->normal_x[i]);
+
+		if(!i) {
+			/* the tail beyond R, Marsaglia's method */
+			do {
+				x = log(ZIG_OPEN_UNIFORM(rule30_dist_word(state)))/ZIG_NORMAL_R;
+				y = log(ZIG_OPEN_UNIFORM(rule30_dist_word(state)));
+			} while(-2.0*y < x*x);
+			return((u < 0) ? x - ZIG_NORMAL_R : ZIG_NORMAL_R - x);
+		}
+
+		/* the wedge between the rectangle and the density */
+		x = u*zig->normal_x[i];
+		f0 = exp(-0.5*(zig->normal_x[i]*zig->normal_x[i] - x*x));
+		f1 = exp(-0.5*(zig->normal_x[i + 1]*zig->normal_x[i + 1] - x*x));
+		if(f1 + ZIG_UNIFORM(rule30_dist_word(state))*(f0 - f1) < 1.0)
+			return(x);
+
+		word = rule30_dist_word(state);
+
+	}
+
+}
+
+/* the exponential ziggurat from a word that missed the rectangle of its layer */
+static inline double rule30_zig_exp_slow(struct rule30_rng_state *state, const struct rule30_zig *zig, uint64_t word) {
+
+	double u, x, f0, f1;
+	int i;
+
+	while(1) {
+
+		i = word & (ZIG_EXP_LAYERS - 1);
+		u = ZIG_UNIFORM(word);
+
+		if(u < zig->exp_r[i])
+			return(u*zig->exp_x[i]);
+
+		/* the tail beyond R is R plus another exponential */
+		if(!i)
+			return(ZIG_EXP_R - log(ZIG_OPEN_UNIFORM(rule30_dist_word(state))));
+
+		x = u*zig->exp_x[i];
+		f0 = exp(-(zig->exp_x[i] - x));
+		f1 = exp(-(zig->exp_x[i + 1] - x));
+		if(f1 + ZIG_UNIFORM(rule30_dist_word(state))*(f0 - f1) < 1.0)
+			return(x);
+
+		word = rule30_dist_word(state);
+
+	}
+
+}
+
+/* the fast path for a chunk of words: each word's uniform scaled to the width of its	*/
+/* layer, and a miss flag where it falls outside the rectangle of the layer - no	*/
+/* branches, so the loop runs at the throughput of the two table loads per word	*/
+static inline __attribute__((always_inline)) void rule30_zig_fast(const uint64_t *chunk, size_t count, const double *x, const double *r, int layers, int symmetric, double *buf, unsigned char *miss) {
+
+	double u;
+	size_t i;
+	int layer;
+
+	for(i = 0; i < count; i++) {
+		layer = *(chunk + i) & (layers - 1);
+		u = symmetric ? ZIG_SIGNED_UNIFORM(*(chunk + i)) : ZIG_UNIFORM(*(chunk + i));
+		*(buf + i) = u*(*(x + layer));
+		*(miss + i) = !(fabs(u) < *(r + layer));
+	}
+
+}
+
+/* the next n standard normal variates of the stream - one word each, bar the rare	*/
+/* wedge and tail cases which draw more							*/
+static inline void rule30_dist_fill_normal(struct rule30_rng_state *state, const struct rule30_zig *zig, double *buf, size_t n) {
+
+	uint64_t chunk[DIST_CHUNK];
+	unsigned char miss[DIST_CHUNK];
+	size_t count, i;
+
+	while(n) {
+
+		count = (n < DIST_CHUNK) ? n : DIST_CHUNK;
+		rule30_rng_fill_u64(state, chunk, count);
+
+		rule30_zig_fast(chunk, count, zig->normal_x, zig->normal_r, ZIG_NORMAL_LAYERS, 1, buf, miss);
+
+		/* then the scalar fallback for the ~1% that missed */
+		for(i = 0; i < count; i++)
+			if(*(miss + i))
+				*(buf + i) = rule30_zig_normal_slow(state, zig, *(chunk + i));
+
+		buf += count;
+		n -= count;
+
+	}
+
+}
+
+/* the next n exponential variates of mean 1 of the stream */
+static inline void rule30_dist_fill_exponential(struct rule30_rng_state *state, const struct rule30_zig *zig, double *buf, size_t n) {
+
+	uint64_t chunk[DIST_CHUNK];
+	unsigned char miss[DIST_CHUNK];
+	size_t count, i;
+
+	while(n) {
+
+		count = (n < DIST_CHUNK) ? n : DIST_CHUNK;
+		rule30_rng_fill_u64(state, chunk, count);
+
+		rule30_zig_fast(chunk, count, zig->exp_x, zig->exp_r, ZIG_EXP_LAYERS, 0, buf, miss);
+
+		for(i = 0; i < count; i++)
+			if(*(miss + i))
+				*(buf + i) = rule30_zig_exp_slow(state, zig, *(chunk + i));
+
+		buf += count;
+		n -= count;
+
+	}
+
+}
+
+#endif /* RULE30_DIST_H */
@@ -0,0 +1,129 @@
+/************************************************************************/
+/* Build and read checkpoint indexes of rule 30 streams			*/
+/*									*/
+/* Builds (or extends) an index of the stream from a seed, a snapshot	*/
+/* of the lattice every K generations, and reads numbers from any	*/
+/* position of an indexed stream without replaying it from the seed:	*/
+/*									*/
+/*	rule30index -b file -s seed [-f] -k interval -n snapshots	*/
+/*	rule30index -r file -p position [-u double|u64|gen] [-c count]	*/
+/*									*/
+/* -f indexes the fully seeded stream of rule30_rng_init_full() instead	*/
+/* of rule30_rng_init().  Positions count doubles (the default), 64-bit	*/
+/* words or generations from the seeded state, counting from 0;		*/
+/* rule30rng drops double 0, so its line n is double n.  Reading prints	*/
+/* count numbers in the format of rule30rng.  A position after the last	*/
+/* snapshot is stepped to from it, with a warning, and one past		*/
+/* generation 2^64 - 1 is refused.					*/
+/*									*/
+/* compile with:							*/
+/*	gcc -O3 -o rule30index rule30.index.c				*/
+/************************************************************************/
+
+#include "rule30.index.h"
+
+void usage(char *progname) {
+
+	fprintf(stderr, "usage: %s -b file -s seed [-f] -k interval -n snapshots\n", progname);
+	fprintf(stderr, "       %s -r file -p position [-u double|u64|gen] [-c count]\n", progname);
+	exit(1);
+
+}
+
+int main(int argc, char **argv) {
+
+	int c, full = 0;
+	char *build = NULL, *lookup = NULL, *unit = "double";
+	unsigned long int seed = 0;
+	uint64_t interval = 0, count = 0, position = 0, generation, scale = 1, n = 1, i;
+	struct rule30_index index;
+	struct rule30_rng_state state;
+	uint64_t word;
+
+	while((c = getopt(argc, argv, "b:r:s:fk:n:p:u:c:")) != -1) {
+		switch(c) {
+			case 'b':
+				build = optarg;
+				break;
+			case 'r':
+				lookup = optarg;
+				break;
+			case 's':
+				seed = strtoul(optarg, NULL, 0);
+				break;
+			case 'f':
+				full = 1;
+				break;
+			case 'k':
+				interval = strtoull(optarg, NULL, 0);
+				break;
+			case 'n':
+				count = strtoull(optarg, NULL, 0);
+				break;
+			case 'p':
+				position = strtoull(optarg, NULL, 0);
+				break;
+			case 'u':
+				unit = optarg;
+				break;
+			case 'c':
+				n = strtoull(optarg, NULL, 0);
+				break;
+			default:
+				usage((char *)argv[0]);
+		}
+	}
+	if(!build == !lookup) usage((char *)argv[0]);
+
+	if(build) {
+
+		if(!seed || !interval || !count) usage((char *)argv[0]);
+		if(rule30_index_build(build, seed, full, interval, count)) {
+			fprintf(stderr, "couldn't build %s - an index of another stream or width, or an I/O error\n", build);
+			exit(1);
+		}
+
+	} else {
+
+		if(rule30_index_open(&index, lookup)) {
+			fprintf(stderr, "couldn't open %s as an index for this build\n", lookup);
+			exit(1);
+		}
+
+		if(!strcmp(unit, "double"))
+			scale = DELTA_MANTISSA;
+		else if(!strcmp(unit, "u64"))
+			scale = 64;
+		else if(!strcmp(unit, "gen"))
+			scale = 1;
+		else
+			usage((char *)argv[0]);
+		if(position > UINT64_MAX/scale) {
+			fprintf(stderr, "position %llu is past generation 2^64 - 1, the last a position can name\n", (unsigned long long)position);
+			exit(1);
+		}
+		generation = position*scale;
+
+		/* the last snapshot is generation (count - 1)*interval */
+		if(generation > (index.count - 1)*index.header->interval)
+			fprintf(stderr, "# position is past the end of the index, stepping %llu generations from the last snapshot\n",
+				(unsigned long long)(generation - (index.count - 1)*index.header->interval));
+
+		rule30_index_seek(&index, generation, &state);
+		for(i = 0; i < n; i++) {
+			if(!strcmp(unit, "double"))
+				printf("%.16f\n", rule30_rng_next(&state));
+			else {
+				/* 64 generations from the position, whatever its unit */
+				rule30_rng_fill_u64(&state, &word, 1);
+				printf("%016llx\n", (unsigned long long)word);
+			}
+		}
+
+		rule30_index_close(&index);
+
+	}
+
+	exit(0);
+
+}
@@ -0,0 +1,221 @@
+/************************************************************************/
+/* Checkpoint index for long rule 30 streams				*/
+/*									*/
+/* Rule 30 has no jump-ahead, so reaching number 10^12 of a stream	*/
+/* means stepping every generation before it.  An index file stores the	*/
+/* lattice (RNG_REGS registers) of one stream every K generations, so	*/
+/* that any position can be reached from the nearest snapshot in at	*/
+/* most K - 1 generations:						*/
+/*									*/
+/*	rule30_index_build()	create an index, or extend one that	*/
+/*				an interrupted or shorter build left	*/
+/*	rule30_index_open()	map an index read-only			*/
+/*	rule30_index_seek()	the stream state at any generation	*/
+/*	rule30_index_close()	unmap it				*/
+/*									*/
+/* Positions are counted in generations from the freshly seeded state:	*/
+/* double n of rule30_rng_next() starts at generation n*DELTA_MANTISSA	*/
+/* and word n of rule30_rng_fill_u64() at n*64.  The file is a fixed	*/
+/* header followed by the snapshots, 8 bytes per register, in the byte	*/
+/* order of the machine that built it (the magic number catches a	*/
+/* mismatch).  The header's snapshot count is only advanced once a	*/
+/* snapshot is written, with a release store, so a build that is killed	*/
+/* leaves a valid index that the next build extends, and a reader	*/
+/* mapping the file meanwhile never sees a count ahead of the		*/
+/* snapshots.  A build only starts afresh on an empty file; any other	*/
+/* file must be an index of the same stream.				*/
+/************************************************************************/
+
+#ifndef RULE30_INDEX_H
+#define RULE30_INDEX_H
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "rule30.rng.h"
+
+#define INDEX_MAGIC	0x5845444E49303352ULL	/* "R30INDEX" */
+#define INDEX_VERSION	1
+
+struct rule30_index_header {
+
+	uint64_t magic;
+	uint32_t version;
+	uint32_t regs;		/* registers per snapshot, RNG_REGS of the builder */
+	uint64_t seed;
+	uint32_t full;		/* seeded with rule30_rng_init_full() rather than rule30_rng_init() */
+	uint32_t reserved;
+	uint64_t interval;	/* generations between snapshots */
+	uint64_t count;		/* snapshots written, the first being the seeded state */
+
+};
+
+struct rule30_index {
+
+	void *map;
+	size_t length;
+	const struct rule30_index_header *header;
+	const uint64_t *snapshot;
+	uint64_t count;			/* snapshots in the file when it was mapped */
+
+};
+
+#define INDEX_BYTES(count)	(sizeof(struct rule30_index_header) + (size_t)(count)*RNG_REGS*sizeof(uint64_t))
+
+/* seed a stream as the index says */
+static inline void rule30_index_seed(const struct rule30_index_header *header, struct rule30_rng_state *state) {
+
+	if(header->full)
+		rule30_rng_init_full(state, header->seed);
+	else
+		rule30_rng_init(state, header->seed);
+
+}
+
+/* build the index at path out to count snapshots, interval generations apart, or	*/
+/* extend an existing index of the same stream - returns -1 on failure			*/
+static inline int rule30_index_build(const char *path, unsigned long int seed, int full, uint64_t interval, uint64_t count) {
+
+	struct rule30_index_header *header, existing;
+	struct rule30_rng_state state;
+	struct stat st;
+	uint64_t *snapshot;
+	void *map;
+	size_t length;
+	uint64_t j;
+	int fd, i, status = 0;
+
+	if(!interval || !count)
+		return(-1);
+
+	fd = open(path, O_RDWR | O_CREAT, 0644);
+	if(fd < 0)
+		return(-1);
+
+	/* only an empty file is fresh - anything else must be an index of this stream, whole up	*/
+	/* to its count, and is refused untouched otherwise						*/
+	if(fstat(fd, &st)) {
+		close(fd);
+		return(-1);
+	}
+	if(st.st_size && ((st.st_size < (off_t)INDEX_BYTES(0)) || (pread(fd, &existing, sizeof(existing), 0) != sizeof(existing)) ||
+			  (existing.magic != INDEX_MAGIC) || (existing.version != INDEX_VERSION) || (existing.regs != RNG_REGS) ||
+			  (existing.seed != seed) || (existing.full != (uint32_t)full) || (existing.interval != interval) ||
+			  (existing.count > (uint64_t)(st.st_size - INDEX_BYTES(0))/(RNG_REGS*sizeof(uint64_t))))) {
+		close(fd);
+		return(-1);
+	}
+
+	/* only ever grow the file - a shorter count leaves a longer index alone */
+	length = INDEX_BYTES(count);
+	if((off_t)length < st.st_size)
+		length = st.st_size;
+	if(((off_t)length > st.st_size) && ftruncate(fd, length)) {
+		close(fd);
+		return(-1);
+	}
+
+	map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(map == MAP_FAILED) {
+		close(fd);
+		return(-1);
+	}
+	header = (struct rule30_index_header *)map;
+	snapshot = (uint64_t *)(header + 1);
+
+	if(!st.st_size) {
+		header->magic = INDEX_MAGIC;
+		header->version = INDEX_VERSION;
+		header->regs = RNG_REGS;
+		header->seed = seed;
+		header->full = full;
+		header->reserved = 0;
+		header->interval = interval;
+		header->count = 0;
+	}
+
+	/* carry on from the last snapshot */
+	if(header->count) {
+		for(i = 0; i < RNG_REGS; i++)
+			state.reg[i] = *(snapshot + (header->count - 1)*RNG_REGS + i);
+	}
+	else
+		rule30_index_seed(header, &state);
+
+	for(j = header->count; j < count; j++) {
+
+		if(j)
+			rule30_rng_advance(&state, interval);
+		for(i = 0; i < RNG_REGS; i++)
+			*(snapshot + j*RNG_REGS + i) = state.reg[i];
+		/* publish the snapshot only once it is written */
+		__atomic_store_n(&header->count, j + 1, __ATOMIC_RELEASE);
+
+	}
+
+	if(msync(map, length, MS_SYNC))
+		status = -1;
+	munmap(map, length);
+	close(fd);
+	return(status);
+
+}
+
+/* map the index at path read-only, returns -1 if it is missing or not an index of this build */
+static inline int rule30_index_open(struct rule30_index *index, const char *path) {
+
+	struct stat st;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if(fd < 0)
+		return(-1);
+	if(fstat(fd, &st) || (st.st_size < (off_t)INDEX_BYTES(0))) {
+		close(fd);
+		return(-1);
+	}
+
+	index->length = st.st_size;
+	index->map = mmap(NULL, index->length, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(index->map == MAP_FAILED)
+		return(-1);
+
+	index->header = (const struct rule30_index_header *)index->map;
+	index->snapshot = (const uint64_t *)(index->header + 1);
+	index->count = __atomic_load_n(&index->header->count, __ATOMIC_ACQUIRE);
+	if((index->header->magic != INDEX_MAGIC) || (index->header->version != INDEX_VERSION) || (index->header->regs != RNG_REGS) ||
+	   !index->header->interval || !index->count || (index->length < INDEX_BYTES(index->count))) {
+		munmap(index->map, index->length);
+		return(-1);
+	}
+
+	return(0);
+
+}
+
+/* the state of the indexed stream at generation, from the nearest snapshot at or before it */
+static inline void rule30_index_seek(const struct rule30_index *index, uint64_t generation, struct rule30_rng_state *state) {
+
+	uint64_t j = generation / index->header->interval;
+	int i;
+
+	if(j >= index->count)
+		j = index->count - 1;
+	for(i = 0; i < RNG_REGS; i++)
+		state->reg[i] = *(index->snapshot + j*RNG_REGS + i);
+
+	rule30_rng_advance(state, generation - j*index->header->interval);
+
+}
+
+static inline void rule30_index_close(struct rule30_index *index) {
+
+	munmap(index->map, index->length);
+	index->map = NULL;
+
+}
+
+#endif /* RULE30_INDEX_H */
@@ -0,0 +1,337 @@
+/************************************************************************/
+/* Cycle lengths of rule 30 on cyclic lattices				*/
+/*									*/
+/* Wrapping the register array into a circle makes every orbit of the	*/
+/* automaton eventually periodic, and for a narrow lattice the period	*/
+/* can be short enough to matter.  This tool measures it: for each	*/
+/* lattice width it runs Brent's cycle detection from many random	*/
+/* initial states, spread over a pool of threads, and reports the	*/
+/* distributions of the transient (generations before the orbit enters	*/
+/* its cycle) and of the cycle length.					*/
+/*									*/
+/* Widths up to 64 cells may be any size and are stepped as one word,	*/
+/* rotating within the width; wider lattices must be a whole number of	*/
+/* 64-bit registers and are stepped a register at a time as in ca.h.	*/
+/* Orbits that have not closed within the step cap (-c, in generations)	*/
+/* are counted as capped.  Brent's search takes up to about		*/
+/* 2*max(transient, cycle) + cycle generations to close an orbit, so a	*/
+/* capped orbit's transient plus cycle is only known to be beyond a	*/
+/* third of the cap, which is still usually the answer wanted for wide	*/
+/* lattices.  The cap defaults to 2^32 generations up to 48 cells and	*/
+/* 2^24 over, where cycles outgrow 2^32 and an orbit takes minutes to	*/
+/* give up on.								*/
+/*									*/
+/*	rule30period [-r rule] [-n states] [-j threads] [-c cap]	*/
+/*		     [-s seed] width|first-last ...			*/
+/*									*/
+/* compile with:							*/
+/*	gcc -O3 -o rule30period rule30.period.c -pthread		*/
+/************************************************************************/
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "rule30.rng.h"
+
+#define MAX_REGS	16		/* widest lattice, 1024 cells */
+#define MAX_WIDTHS	256
+#define NUM_STATES	100		/* initial states per width */
+#define STEP_CAP	(1ULL << 32)	/* generations before an orbit is given up on */
+#define WIDE_CAP	(1ULL << 24)	/* the same over CAP_WIDTH cells, unless -c is given */
+#define CAP_WIDTH	48
+#define TOP_CYCLES	4		/* most common cycle lengths reported */
+
+/* one orbit to measure */
+struct orbit {
+
+	int width;
+	unsigned long int reg[MAX_REGS];
+	uint64_t transient;
+	uint64_t cycle;
+	int capped;
+
+};
+
+/* the work shared by the threads */
+struct job {
+
+	struct orbit *orbit;
+	int count;
+	int next;
+	pthread_mutex_t lock;
+	unsigned long int rule;
+	uint64_t cap;		/* 0 for the default by width */
+
+};
+
+/* one generation of a lattice of width cells, in place */
+static inline __attribute__((always_inline)) void step(unsigned long int *reg, int width, unsigned long int rule) {
+
+	unsigned long int next[MAX_REGS], mask;
+	int regs = width / WORDSIZE, i;
+
+	if(width <= WORDSIZE) {
+		/* one word, the cells in the low width bits */
+		mask = (width == WORDSIZE) ? ~0UL : (1UL << width) - 1;
+		*reg = CA_RULE(rule, ((*reg >> 1) | (*reg << (width - 1))) & mask, *reg, ((*reg << 1) | (*reg >> (width - 1))) & mask) & mask;
+		return;
+	}
+
+	for(i = 0; i < regs; i++)
+		next[i] = CA_RULE(rule, CA_LEFT_OF(*(reg + i), *(reg + (i + regs - 1) % regs), WORDSIZE),
+				  *(reg + i), CA_RIGHT_OF(*(reg + i), *(reg + (i + 1) % regs), WORDSIZE));
+	memcpy(reg, next, regs*sizeof(unsigned long int));
+
+}
+
+/* Brent's cycle detection - the cycle length by doubling the distance between tortoise	*/
+/* and hare, then the transient by walking two copies that length apart			*/
+static inline __attribute__((always_inline)) void brent(struct orbit *orbit, unsigned long int rule, uint64_t cap) {
+
+	unsigned long int tortoise[MAX_REGS], hare[MAX_REGS];
+	size_t bytes = ((orbit->width + WORDSIZE - 1) / WORDSIZE)*sizeof(unsigned long int);
+	uint64_t power = 1, cycle = 1, steps = 1, i;
+
+	memcpy(tortoise, orbit->reg, bytes);
+	memcpy(hare, orbit->reg, bytes);
+	step(hare, orbit->width, rule);
+
+	while(memcmp(tortoise, hare, bytes)) {
+		if(steps++ >= cap) {
+			orbit->capped = 1;
+			return;
+		}
+		if(power == cycle) {
+			memcpy(tortoise, hare, bytes);
+			power <<= 1;
+			cycle = 0;
+		}
+		step(hare, orbit->width, rule);
+		cycle++;
+	}
+
+	memcpy(tortoise, orbit->reg, bytes);
+	memcpy(hare, orbit->reg, bytes);
+	for(i = 0; i < cycle; i++)
+		step(hare, orbit->width, rule);
+	for(orbit->transient = 0; memcmp(tortoise, hare, bytes); orbit->transient++) {
+		step(tortoise, orbit->width, rule);
+		step(hare, orbit->width, rule);
+	}
+
+	orbit->cycle = cycle;
+	orbit->capped = 0;
+
+}
+
+/* a worker thread - take orbits until there are none left */
+void *worker(void *arg) {
+
+	struct job *job = (struct job *)arg;
+	uint64_t cap;
+	int i;
+
+	while(1) {
+
+		pthread_mutex_lock(&job->lock);
+		i = job->next++;
+		pthread_mutex_unlock(&job->lock);
+		if(i >= job->count)
+			break;
+
+		cap = job->cap ? job->cap : ((job->orbit[i].width > CAP_WIDTH) ? WIDE_CAP : STEP_CAP);
+
+		/* with the rule folded into the kernel for rule 30 */
+		if(job->rule == RULE30)
+			brent(&job->orbit[i], RULE30, cap);
+		else
+			brent(&job->orbit[i], job->rule, cap);
+
+	}
+
+	return(NULL);
+
+}
+
+int compare_u64(const void *a, const void *b) {
+
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return((x > y) - (x < y));
+
+}
+
+/* one line of results for the orbits of a width */
+void report(struct orbit *orbit, int states) {
+
+	uint64_t *transient, *cycle;
+	uint64_t common[TOP_CYCLES], length;
+	int counts[TOP_CYCLES], closed = 0, distinct = 0, run, i, j, k;
+
+	/* as many as -n asks for, so off the stack */
+	transient = (uint64_t *)malloc(states*sizeof(uint64_t));
+	cycle = (uint64_t *)malloc(states*sizeof(uint64_t));
+	if(!transient || !cycle) {
+		fprintf(stderr, "couldn't allocate working memory\n");
+		exit(1);
+	}
+
+	for(i = 0; i < states; i++) {
+		if(orbit[i].capped)
+			continue;
+		transient[closed] = orbit[i].transient;
+		cycle[closed++] = orbit[i].cycle;
+	}
+
+	printf("%6d %7d %7d", orbit[0].width, states, states - closed);
+	if(!closed) {
+		printf("\n");
+		free(transient);
+		free(cycle);
+		return;
+	}
+
+	qsort(transient, closed, sizeof(uint64_t), compare_u64);
+	qsort(cycle, closed, sizeof(uint64_t), compare_u64);
+
+	/* the most common cycle lengths - the sorted cycles come in runs */
+	for(k = 0; k < TOP_CYCLES; k++)
+		counts[k] = 0;
+	for(i = 0; i < closed; i = j) {
+		length = cycle[i];
+		for(j = i; (j < closed) && (cycle[j] == length); j++);
+		run = j - i;
+		distinct++;
+		for(k = 0; k < TOP_CYCLES; k++) {
+			if(run > counts[k]) {
+				memmove(&counts[k + 1], &counts[k], (TOP_CYCLES - k - 1)*sizeof(int));
+				memmove(&common[k + 1], &common[k], (TOP_CYCLES - k - 1)*sizeof(uint64_t));
+				counts[k] = run;
+				common[k] = length;
+				break;
+			}
+		}
+	}
+
+	printf(" %12llu %12llu %12llu %14llu %14llu %14llu %8d ",
+		(unsigned long long)transient[0], (unsigned long long)transient[closed/2], (unsigned long long)transient[closed - 1],
+		(unsigned long long)cycle[0], (unsigned long long)cycle[closed/2], (unsigned long long)cycle[closed - 1], distinct);
+	for(k = 0; (k < TOP_CYCLES) && counts[k]; k++)
+		printf(" %llu(%d%%)", (unsigned long long)common[k], (100*counts[k] + closed/2)/closed);
+	printf("\n");
+
+	free(transient);
+	free(cycle);
+
+}
+
+void usage(char *progname) {
+
+	fprintf(stderr, "usage: %s [-r rule] [-n states] [-j threads] [-c cap] [-s seed] width|first-last ...\n", progname);
+	fprintf(stderr, "\twidths are 2 to %d cells, or multiples of %d up to %d\n", WORDSIZE, WORDSIZE, MAX_REGS*WORDSIZE);
+	fprintf(stderr, "\t-c\tgenerations before an orbit is capped (default %llu, %llu over %d cells)\n",
+		(unsigned long long)STEP_CAP, (unsigned long long)WIDE_CAP, CAP_WIDTH);
+	exit(1);
+
+}
+
+int main(int argc, char **argv) {
+
+	int c, i, j, k, w, count = 0, threads = 1, states = NUM_STATES, first, last;
+	int widths[MAX_WIDTHS];
+	unsigned long int seed = 1234523, mask;
+	char *dash;
+	uint64_t z, x;
+	struct job job;
+	pthread_t *thread;
+
+	job.rule = RULE30;
+	job.cap = 0;
+	while((c = getopt(argc, argv, "r:n:j:c:s:")) != -1) {
+		switch(c) {
+			case 'r':
+				job.rule = strtoul(optarg, NULL, 0);
+				break;
+			case 'n':
+				states = atoi(optarg);
+				break;
+			case 'j':
+				threads = atoi(optarg);
+				break;
+			case 'c':
+				if(!(job.cap = strtoull(optarg, NULL, 0)))
+					usage((char *)argv[0]);
+				break;
+			case 's':
+				seed = strtoul(optarg, NULL, 0);
+				break;
+			default:
+				usage((char *)argv[0]);
+		}
+	}
+	if((job.rule > 255) || (states < 1) || (threads < 1) || (optind == argc)) usage((char *)argv[0]);
+
+	/* the widths, single or as ranges */
+	for(i = optind; i < argc; i++) {
+		first = last = atoi(argv[i]);
+		if((dash = strchr(argv[i], '-')))
+			last = atoi(dash + 1);
+		for(w = first; w <= last; w++) {
+			if((w < 2) || ((w > WORDSIZE) && ((w % WORDSIZE) || (w > MAX_REGS*WORDSIZE))) || (count == MAX_WIDTHS))
+				usage((char *)argv[0]);
+			widths[count++] = w;
+		}
+	}
+
+	/* random initial states, splitmix64 from the seed */
+	job.count = count*states;
+	job.next = 0;
+	job.orbit = (struct orbit *)calloc(job.count, sizeof(struct orbit));
+	thread = (pthread_t *)calloc(threads, sizeof(pthread_t));
+	if(!job.orbit || !thread) {
+		fprintf(stderr, "couldn't allocate working memory\n");
+		exit(1);
+	}
+	pthread_mutex_init(&job.lock, NULL);
+
+	z = seed;
+	for(i = 0; i < count; i++) {
+		for(j = 0; j < states; j++) {
+			job.orbit[i*states + j].width = widths[i];
+			for(k = 0; k < (widths[i] + WORDSIZE - 1) / WORDSIZE; k++) {
+				z += 0x9E3779B97F4A7C15ULL;
+				x = z;
+				x = (x ^ (x >> 30))*0xBF58476D1CE4E5B9ULL;
+				x = (x ^ (x >> 27))*0x94D049BB133111EBULL;
+				job.orbit[i*states + j].reg[k] = x ^ (x >> 31);
+			}
+			if(widths[i] < WORDSIZE) {
+				mask = (1UL << widths[i]) - 1;
+				job.orbit[i*states + j].reg[0] &= mask;
+			}
+		}
+	}
+
+	for(i = 0; i < threads; i++) {
+		if(pthread_create(&thread[i], NULL, worker, &job)) {
+			fprintf(stderr, "couldn't start thread %d\n", i);
+			exit(1);
+		}
+	}
+	for(i = 0; i < threads; i++)
+		pthread_join(thread[i], NULL);
+
+	printf("# rule %lu, %d random initial states per width, cap %llu generations", job.rule, states, (unsigned long long)(job.cap ? job.cap : STEP_CAP));
+	if(!job.cap)
+		printf(" (%llu over %d cells)", (unsigned long long)WIDE_CAP, CAP_WIDTH);
+	printf("\n");
+	printf("# %5s %7s %7s %12s %12s %12s %14s %14s %14s %8s  %s\n", "width", "states", "capped",
+		"trans min", "trans med", "trans max", "cycle min", "cycle med", "cycle max", "distinct", "common cycles");
+	for(i = 0; i < count; i++)
+		report(&job.orbit[i*states], states);
+
+	free(job.orbit);
+	free(thread);
+	exit(0);
+
+}
@@ -0,0 +1,256 @@
+/************************************************************************/
+/* Producer pool for the rule 30 generator				*/
+/*									*/
+/* A generator service inside the library: each of N worker threads	*/
+/* owns a lattice of its own (seeded with rule30_rng_init_full()) and	*/
+/* fills blocks of POOL_BLOCK 64-bit words, harvested from the default	*/
+/* tap set, into a ring of POOL_SLOTS blocks.  Every ring has exactly	*/
+/* one producer (its worker) and one consumer, so it is lock-free: the	*/
+/* head and tail indices sit on cache lines of their own and are only	*/
+/* ever advanced by one side, with release/acquire ordering to publish	*/
+/* the blocks.  The CA work thus overlaps the consumers' own		*/
+/* computation and a consumer waits only when it drains its ring faster	*/
+/* than the worker refills it.  A worker whose ring is full spins	*/
+/* briefly and then sleeps (on a futex under Linux, elsewhere with a	*/
+/* growing nanosleep) until its consumer releases a block, so idle	*/
+/* workers cost no CPU while the consumers are busy.			*/
+/*									*/
+/*	rule30_pool_start()		start N workers from a seed	*/
+/*	rule30_pool_acquire()		next full block, waiting	*/
+/*	rule30_pool_try_acquire()	next full block, or NULL	*/
+/*	rule30_pool_release()		give the block back		*/
+/*	rule30_pool_stop()		stop and join the workers	*/
+/*									*/
+/* Consumer i takes blocks from ring i only, in order - the blocks of a	*/
+/* ring are the consecutive output of worker i, so a run is		*/
+/* reproducible from the seed and the ring it reads.  Link with		*/
+/* -pthread.								*/
+/************************************************************************/
+
+#ifndef RULE30_POOL_H
+#define RULE30_POOL_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif /* __linux__ */
+
+#include "rule30.rng.h"
+
+#ifndef POOL_BLOCK
+#define POOL_BLOCK	512		/* 64-bit words per block, 4 kB */
+#endif
+#ifndef POOL_SLOTS
+#define POOL_SLOTS	8		/* blocks per ring, a power of two */
+#endif
+#define POOL_LINE	64		/* cache line */
+#define POOL_SPINS	64		/* yields by a worker with a full ring before it sleeps */
+#define POOL_NAP	1000		/* first nanosleep without futexes, doubling up to POOL_NAP_MAX */
+#define POOL_NAP_MAX	1000000
+#define POOL_SPREAD	0xD6E8FEB86659FD93UL	/* separates the worker seeds */
+
+/* a single-producer/single-consumer ring of blocks, one per worker */
+struct rule30_ring {
+
+	_Atomic size_t head __attribute__((aligned(POOL_LINE)));	/* blocks filled - written by the worker */
+	_Atomic size_t tail __attribute__((aligned(POOL_LINE)));	/* blocks consumed - written by the consumer */
+	_Atomic uint32_t wake;						/* bumped to wake a sleeping worker */
+	atomic_int sleeping;						/* the worker is (about to be) asleep */
+	struct rule30_rng_state state;					/* the worker's lattice */
+	uint64_t block[POOL_SLOTS][POOL_BLOCK] __attribute__((aligned(POOL_LINE)));
+
+};
+
+struct rule30_pool {
+
+	int workers;
+	atomic_int stop;
+	struct rule30_ring *ring;
+	pthread_t *thread;
+
+};
+
+struct rule30_pool_worker {
+
+	struct rule30_pool *pool;
+	struct rule30_ring *ring;
+
+};
+
+/* wake the worker of a ring if it is asleep - called after the tail or the stop flag has	*/
+/* been stored, which the fence orders before the check of sleeping			*/
+static inline void rule30_pool_wake(struct rule30_ring *ring) {
+
+	atomic_thread_fence(memory_order_seq_cst);
+	if(atomic_load_explicit(&ring->sleeping, memory_order_relaxed)) {
+		atomic_fetch_add_explicit(&ring->wake, 1, memory_order_relaxed);
+#ifdef __linux__
+		syscall(SYS_futex, &ring->wake, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#endif /* __linux__ */
+	}
+
+}
+
+/* a worker with a full ring: sleep until the consumer frees a slot or the pool stops */
+static inline void rule30_pool_sleep(struct rule30_pool *pool, struct rule30_ring *ring, size_t head) {
+
+	uint32_t wake = atomic_load_explicit(&ring->wake, memory_order_relaxed);
+#ifndef __linux__
+	struct timespec nap = { 0, POOL_NAP };
+#endif /* __linux__ */
+
+	atomic_store_explicit(&ring->sleeping, 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	while((head - atomic_load_explicit(&ring->tail, memory_order_acquire) == POOL_SLOTS) &&
+	      !atomic_load_explicit(&pool->stop, memory_order_relaxed)) {
+#ifdef __linux__
+		/* returns at once if a release has bumped wake since it was read */
+		syscall(SYS_futex, &ring->wake, FUTEX_WAIT_PRIVATE, wake, NULL, NULL, 0);
+		wake = atomic_load_explicit(&ring->wake, memory_order_relaxed);
+#else
+		nanosleep(&nap, NULL);
+		if(nap.tv_nsec < POOL_NAP_MAX)
+			nap.tv_nsec *= 2;
+#endif /* __linux__ */
+	}
+	atomic_store_explicit(&ring->sleeping, 0, memory_order_relaxed);
+
+}
+
+/* the worker: refill the ring whenever a slot is free */
+static void *rule30_pool_produce(void *arg) {
+
+	struct rule30_pool *pool = ((struct rule30_pool_worker *)arg)->pool;
+	struct rule30_ring *ring = ((struct rule30_pool_worker *)arg)->ring;
+	struct rule30_taps taps;
+	size_t head;
+	int spins = 0;
+
+	free(arg);
+	rule30_taps_default(&taps);
+
+	head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	while(!atomic_load_explicit(&pool->stop, memory_order_relaxed)) {
+
+		/* ring full - let the consumer catch up, and sleep if it takes a while */
+		if(head - atomic_load_explicit(&ring->tail, memory_order_acquire) == POOL_SLOTS) {
+			if(spins++ < POOL_SPINS)
+				sched_yield();
+			else
+				rule30_pool_sleep(pool, ring, head);
+			continue;
+		}
+		spins = 0;
+
+		rule30_rng_fill_u64_taps(&ring->state, &taps, ring->block[head % POOL_SLOTS], POOL_BLOCK);
+		atomic_store_explicit(&ring->head, ++head, memory_order_release);
+
+	}
+
+	return(NULL);
+
+}
+
+/* stop and join the workers, freeing the rings */
+static inline void rule30_pool_stop(struct rule30_pool *pool) {
+
+	int i;
+
+	atomic_store_explicit(&pool->stop, 1, memory_order_relaxed);
+	for(i = 0; i < pool->workers; i++) {
+		rule30_pool_wake(&pool->ring[i]);
+		pthread_join(pool->thread[i], NULL);
+	}
+
+	free(pool->ring);
+	free(pool->thread);
+	pool->ring = NULL;
+	pool->thread = NULL;
+	pool->workers = 0;
+
+}
+
+/* start the worker threads, each with its own ring and lattice, returns -1 on failure */
+static inline int rule30_pool_start(struct rule30_pool *pool, int workers, unsigned long int seed) {
+
+	struct rule30_pool_worker *arg;
+	int i;
+
+	if(workers < 1)
+		return(-1);
+
+	pool->workers = workers;
+	atomic_init(&pool->stop, 0);
+	pool->thread = (pthread_t *)calloc(workers, sizeof(pthread_t));
+	if(!pool->thread || posix_memalign((void **)&pool->ring, POOL_LINE, workers*sizeof(struct rule30_ring))) {
+		free(pool->thread);
+		return(-1);
+	}
+
+	for(i = 0; i < workers; i++) {
+
+		atomic_init(&pool->ring[i].head, 0);
+		atomic_init(&pool->ring[i].tail, 0);
+		atomic_init(&pool->ring[i].wake, 0);
+		atomic_init(&pool->ring[i].sleeping, 0);
+		rule30_rng_init_full(&pool->ring[i].state, seed + i*POOL_SPREAD);
+
+		arg = (struct rule30_pool_worker *)malloc(sizeof(struct rule30_pool_worker));
+		if(arg) {
+			arg->pool = pool;
+			arg->ring = &pool->ring[i];
+		}
+		if(!arg || pthread_create(&pool->thread[i], NULL, rule30_pool_produce, arg)) {
+			free(arg);
+			pool->workers = i;
+			rule30_pool_stop(pool);
+			return(-1);
+		}
+
+	}
+
+	return(0);
+
+}
+
+/* the next full block of ring i, or NULL if the worker has not filled one yet */
+static inline const uint64_t *rule30_pool_try_acquire(struct rule30_pool *pool, int i) {
+
+	struct rule30_ring *ring = &pool->ring[i];
+	size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+	if(atomic_load_explicit(&ring->head, memory_order_acquire) == tail)
+		return(NULL);
+
+	return(ring->block[tail % POOL_SLOTS]);
+
+}
+
+/* the next full block of ring i, waiting for the worker if the ring is empty */
+static inline const uint64_t *rule30_pool_acquire(struct rule30_pool *pool, int i) {
+
+	const uint64_t *block;
+
+	while(!(block = rule30_pool_try_acquire(pool, i)))
+		sched_yield();
+
+	return(block);
+
+}
+
+/* done with the block from the last acquire on ring i - the worker may refill it */
+static inline void rule30_pool_release(struct rule30_pool *pool, int i) {
+
+	struct rule30_ring *ring = &pool->ring[i];
+
+	atomic_store_explicit(&ring->tail, atomic_load_explicit(&ring->tail, memory_order_relaxed) + 1, memory_order_release);
+	rule30_pool_wake(ring);
+
+}
+
+#endif /* RULE30_POOL_H */
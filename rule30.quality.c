@@ -0,0 +1,270 @@
+/************************************************************************/
+/* Statistical quality of rule 30 tap sets				*/
+/*									*/
+/* Reading several columns of the lattice per generation gives that	*/
+/* many more random bits for the same CA work, at the risk of		*/
+/* correlations between the columns (a cell's influence travels one	*/
+/* column per generation, so bits from nearby taps resurface a few	*/
+/* generations later).  This utility measures the trade-off: the same	*/
+/* battery is run on the classic single center tap, the default tap set	*/
+/* and optionally a user tap set, and the cost and statistics are	*/
+/* printed side by side.						*/
+/*									*/
+/* The battery, on the 64-bit output words as one bitstream:		*/
+/*									*/
+/*	monobit		fraction of ones (NIST SP 800-22 2.1)		*/
+/*	runs		number of runs of equal bits (NIST 2.3)		*/
+/*	bytes		chi-square of the byte histogram, 255 dof	*/
+/*	autocorr	bit autocorrelation, worst lag of 1..LAGS with	*/
+/*			the p-value Bonferroni corrected for LAGS tests	*/
+/*									*/
+/* Each test prints its p-value, which should be uniform on (0, 1) for	*/
+/* a good generator - a p-value below 1e-4 is flagged.  The default	*/
+/* taps are also run from the classic seeding, whose lattice is		*/
+/* periodic in one register, to show why tap sets need			*/
+/* rule30_rng_init_full(), and the last row is the counter-based	*/
+/* generator of rule30.ctr.h.						*/
+/*									*/
+/* compile with:							*/
+/*	gcc -O3 -o rule30quality rule30.quality.c -lm			*/
+/************************************************************************/
+
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rule30.rng.h"
+#include "rule30.ctr.h"
+
+#define NUM_WORDS	(1 << 20)	/* 64 Mbit per tap set */
+#define LAGS		512		/* autocorrelation lags tested */
+#define SUSPECT		1.0e-4		/* p-values below this are flagged */
+
+/* p-value of a standard normal statistic, two-sided */
+double normal_p(double z) {
+
+	return(erfc(fabs(z)/sqrt(2.0)));
+
+}
+
+/* upper tail of a chi-square statistic, by the Wilson-Hilferty normal approximation */
+double chisq_p(double chisq, int dof) {
+
+	double z;
+
+	z = (pow(chisq/dof, 1.0/3.0) - (1.0 - 2.0/(9.0*dof)))/sqrt(2.0/(9.0*dof));
+	return(0.5*erfc(z/sqrt(2.0)));
+
+}
+
+/* bit i of the stream, most significant bit of each word first */
+#define STREAM_BIT(dat, i)	((*((dat) + ((i) >> 6)) >> (63 - ((i) & 63))) & RHS_ONE)
+
+/* frequency of ones */
+double monobit(uint64_t *dat, size_t num) {
+
+	size_t i;
+	long long int ones = 0;
+	double bits = 64.0*num;
+
+	for(i = 0; i < num; i++)
+		ones += __builtin_popcountll(*(dat + i));
+
+	return(normal_p((2.0*ones - bits)/sqrt(bits)));
+
+}
+
+/* number of runs of identical bits, counted as the number of bit transitions */
+double runs(uint64_t *dat, size_t num) {
+
+	size_t i;
+	long long int ones = 0, transitions = 0;
+	double bits = 64.0*num, pi;
+
+	for(i = 0; i < num; i++) {
+		ones += __builtin_popcountll(*(dat + i));
+		transitions += __builtin_popcountll(*(dat + i) ^ ((*(dat + i) << 1) | ((i + 1 < num) ? (*(dat + i + 1) >> 63) : (*(dat + i) & 1))));
+	}
+
+	pi = ones/bits;
+	if(fabs(pi - 0.5) >= 2.0/sqrt(bits))
+		return(0.0);	/* the monobit prerequisite fails */
+
+	return(erfc(fabs(transitions + 1 - 2.0*bits*pi*(1.0 - pi))/(2.0*sqrt(2.0*bits)*pi*(1.0 - pi))));
+
+}
+
+/* chi-square of the byte histogram */
+double bytes(uint64_t *dat, size_t num) {
+
+	size_t i;
+	int j;
+	long long int hist[256] = { 0 };
+	double expected = 8.0*num/256.0, chisq = 0;
+
+	for(i = 0; i < num; i++)
+		for(j = 0; j < 64; j += 8)
+			hist[(*(dat + i) >> j) & 0xFF]++;
+
+	for(j = 0; j < 256; j++)
+		chisq += (hist[j] - expected)*(hist[j] - expected)/expected;
+
+	return(chisq_p(chisq, 255));
+
+}
+
+/* bit autocorrelation at lags 1..LAGS - the stream is XOR'd against itself shifted by	*/
+/* the lag a word at a time, returns the worst corrected p-value and its lag		*/
+double autocorr(uint64_t *dat, size_t num, int *worst_lag) {
+
+	size_t i;
+	int lag, q, s;
+	long long int differ;
+	double pairs, p, worst = 1.0;
+	uint64_t shifted;
+
+	for(lag = 1; lag <= LAGS; lag++) {
+
+		q = lag / 64;
+		s = lag % 64;
+		differ = 0;
+		for(i = 0; i + q + 1 < num; i++) {
+			shifted = s ? (*(dat + i + q) << s) | (*(dat + i + q + 1) >> (64 - s)) : *(dat + i + q);
+			differ += __builtin_popcountll(*(dat + i) ^ shifted);
+		}
+		pairs = 64.0*(num - q - 1);
+
+		p = normal_p((2.0*differ - pairs)/sqrt(pairs));
+		if(p < worst) {
+			worst = p;
+			*worst_lag = lag;
+		}
+
+	}
+
+	worst *= LAGS;
+	return(worst < 1.0 ? worst : 1.0);
+
+}
+
+void report(char *label, double p) {
+
+	printf("  %s %.3e%s", label, p, (p < SUSPECT) ? " <--" : "    ");
+
+}
+
+void statistics(char *name, int count, double generations, double seconds, uint64_t *dat, size_t num) {
+
+	int worst_lag = 0;
+
+	printf("%-16s %2d taps %5.1f gen/word %8.1f MB/s", name, count, generations, 8.0*num/seconds/1.0e6);
+	report("monobit", monobit(dat, num));
+	report("runs", runs(dat, num));
+	report("bytes", bytes(dat, num));
+	report("autocorr", autocorr(dat, num, &worst_lag));
+	printf(" (lag %d)\n", worst_lag);
+
+}
+
+void battery(char *name, struct rule30_taps *taps, int full, unsigned long int seed, uint64_t *dat, size_t num) {
+
+	struct rule30_rng_state state;
+	clock_t initial_time, final_time;
+	double seconds;
+
+	if(full)
+		rule30_rng_init_full(&state, seed);
+	else
+		rule30_rng_init(&state, seed);
+
+	initial_time = clock();
+	rule30_rng_fill_u64_taps(&state, taps, dat, num);
+	final_time = clock();
+	seconds = (double)(final_time - initial_time)/CLOCKS_PER_SEC;
+
+	statistics(name, taps->count, 64.0/taps->count, seconds, dat, num);
+
+}
+
+/* the counter-based generator, words 0..num-1 of the seed's key */
+void counter_battery(unsigned long int seed, uint64_t *dat, size_t num) {
+
+	struct rule30_ctr_key key;
+	clock_t initial_time, final_time;
+	double seconds;
+
+	rule30_ctr_init(&key, seed);
+
+	initial_time = clock();
+	rule30_ctr_fill_u64(&key, 0, dat, num);
+	final_time = clock();
+	seconds = (double)(final_time - initial_time)/CLOCKS_PER_SEC;
+
+	statistics("counter", CTR_REGS, (double)(CTR_WARMUP + 64)/CTR_WORDS, seconds, dat, num);
+
+}
+
+void usage(char *progname) {
+
+	fprintf(stderr, "usage: %s [-s seed] [-n words] [column ...]\n", progname);
+	fprintf(stderr, "\tcolumns are numbered 0 to %d from the left end of the lattice\n", RNG_REGS*WORDSIZE - 1);
+	exit(1);
+
+}
+
+int main(int argc, char **argv) {
+
+	int c, i, count;
+	int columns[64];
+	unsigned long int seed = 1234523;
+	size_t num = NUM_WORDS;
+	uint64_t *dat;
+	struct rule30_taps center, defaults, user;
+
+	while((c = getopt(argc, argv, "s:n:")) != -1) {
+		switch(c) {
+			case 's':
+				seed = strtoul(optarg, NULL, 0);
+				break;
+			case 'n':
+				num = strtoul(optarg, NULL, 0);
+				break;
+			default:
+				usage((char *)argv[0]);
+		}
+	}
+	if(!seed || (num < 2)) usage((char *)argv[0]);
+
+	count = argc - optind;
+	if(count > 64) usage((char *)argv[0]);
+	for(i = 0; i < count; i++)
+		columns[i] = atoi(argv[optind + i]);
+	if(count && rule30_taps_init(&user, columns, count)) {
+		fprintf(stderr, "bad tap set - columns must be distinct and in range\n");
+		usage((char *)argv[0]);
+	}
+
+	/* the classic center column is column (RNG_REGS/2)*WORDSIZE + (WORDSIZE - 1 - DELTA_CENTER) */
+	columns[0] = (RNG_REGS / 2)*WORDSIZE + (WORDSIZE - 1 - DELTA_CENTER);
+	rule30_taps_init(&center, columns, 1);
+	rule30_taps_default(&defaults);
+
+	dat = (uint64_t *)calloc(num, sizeof(uint64_t));
+	if(!dat) {
+		fprintf(stderr, "couldn't allocate working memory buffer\n");
+		exit(1);
+	}
+
+	printf("# %zu words per tap set, seed %lu, p-values below %.0e flagged\n", num, seed, SUSPECT);
+	battery("center", &center, 0, seed, dat, num);
+	battery("center (full)", &center, 1, seed, dat, num);
+	battery("default (full)", &defaults, 1, seed, dat, num);
+	if(count)
+		battery("user (full)", &user, 1, seed, dat, num);
+	battery("default", &defaults, 0, seed, dat, num);
+	counter_battery(seed, dat, num);
+
+	free(dat);
+	exit(0);
+
+}
@@ -1,91 +1,62 @@
 /************************************************************************/
 /* Cellular automata rule 30-derived pseudo random number generator	*/
 /*									*/
-/* This implementation is for both 32 and 64 bit architectures, but is	*/
-/* ideally implemented for 64.  The code has been generalized so that	*/
-/* class III systems other than rule 30 can be utilized for research	*/
-/* purposes.  The scheme makes use a register array upon which the rule	*/
-/* is imposed - the next step in the automata is generated in the set	*/
-/* of output registers.  Each end of the register array is 'wrapped'	*/
-/* into a circular register; while this reduces the periodic interval	*/
-/* of rule 30, the literature notes that this probablistically occurs	*/
-/* on the order of modern cryptographic systems.  To simplify the logic	*/
-/* the rule is implemented directly into the output register array, and	*/
-/* then shifted one bit to the right at the end in order for the output	*/
-/* to align.  Notice that rule 30 could be more cheaply implemented	*/
-/* (at the cost of generality) by (left XOR (middle OR right)) - that	*/
-/* is not done here.  The designated center bit of each iteration is	*/
-/* used to generate the mantissa of the double float returned, as per	*/
-/* Wolfram, "A New Kind of Science".  It is known that Mathematica uses	*/
-/* this exact method in it's implementation of Random[].		*/
+/* This implementation works on an array of 64-bit registers.  The code	*/
+/* has been generalized so that class III systems other than rule 30	*/
+/* can be utilized for research purposes.  The scheme makes use a	*/
+/* register array upon which the rule is imposed - the next step in the	*/
+/* automata is generated in the set of output registers.  Each end of	*/
+/* the register array is 'wrapped' into a circular register; while this	*/
+/* reduces the periodic interval of rule 30, the literature notes that	*/
+/* this probablistically occurs on the order of modern cryptographic	*/
+/* systems.  The rule is imposed on a whole register at a time by the	*/
+/* word-parallel kernel in ca.h, which the compiler folds down to the	*/
+/* minimal boolean formula for the rule - (left XOR (middle OR right))	*/
+/* for rule 30.  The designated center bit of each iteration is used to	*/
+/* generate the mantissa of the double float returned, as per Wolfram,	*/
+/* "A New Kind of Science".  It is known that Mathematica uses this	*/
+/* exact method in it's implementation of Random[].			*/
 /*									*/
-/* Benchmark results:							*/
+/* By default one million doubles are printed as text.  For feeding	*/
+/* statistical batteries that read raw stdin, -b 64 or -b 32 writes	*/
+/* the stream as little-endian binary words instead (for 32 bits each	*/
+/* 64-bit word is split high half first), generated straight into	*/
+/* large page-aligned buffers.  When stdout is a pipe the buffers	*/
+/* are handed to the kernel with vmsplice() rather than copied by	*/
+/* write(), alternating between two buffers each the size of the pipe	*/
+/* so that a buffer is only refilled once the reader has drained it.	*/
+/* -c limits the output to a byte count, -u streams until the reader	*/
+/* goes away, -t harvests the default tap set, -l generates the same	*/
+/* center column stream with the light-cone table engine of		*/
+/* rule30.cone.h and -j N runs N worker threads of rule30.pool.h.	*/
+/*									*/
+/*	rule30rng [-s seed] [-u] [-b 64|32 [-c bytes] [-t|-l] [-j n]]	*/
+/*									*/
+/* Benchmarks are in rule30.bench.c.					*/
 /*									*/
 /* compile with:							*/
-/*	gcc -o rule30rng -funroll-loops -O3 rule30.rng.c		*/
+/*	gcc -o rule30rng -funroll-loops -O3 rule30.rng.c -pthread	*/
 /*									*/
 /* @2005 Jonathan Belof							*/
 /************************************************************************/
 
 /*#define DEBUG*/
-/*#define BENCHMARK*/
-
-#include <sys/types.h>
-#include <stdlib.h>
-#include <stdio.h>
-
-#include <time.h>
-
-#define WORDSIZE	64
-//#define WORDSIZE	32
-
-#if WORDSIZE == 64
-/* 64-bit masks */
-#define RULE30		0x000000000000001E	/* 0000000000000000000000000000000000000000000000000000000000011110 */
-#define RULE110		0x000000000000006E	/* 0000000000000000000000000000000000000000000000000000000001101110 */
-#define RULE10		0x000000000000000A	/* 0000000000000000000000000000000000000000000000000000000000001010 */
-#define RULE90		0x000000000000005A	/* 0000000000000000000000000000000000000000000000000000000001011010 */
-
-#define CELL_MASK	0x0000000000000007	/* 0000000000000000000000000000000000000000000000000000000000000111 */
-#define CENTER_MASK	0x0000000100000000	/* 0000000000000000000000000000000100000000000000000000000000000000 */
-#define DELTA_CENTER	0x0000000000000020	/* 0000000000000000000000000000000000000000000000000000000000100000 */
-#define RHS_ONE		0x0000000000000001	/* 0000000000000000000000000000000000000000000000000000000000000001 */
-#define LHS_ONE		0x8000000000000000	/* 1000000000000000000000000000000000000000000000000000000000000000 */
-#define LHS_ZERO	0x7FFFFFFFFFFFFFFF	/* 0111111111111111111111111111111111111111111111111111111111111111 */
-#define INNER_COUNT	0x00000000000000FF	/* 0000000000000000000000000000000000000000000000000000000011111111 */
-#define INNER_ONE	0x0000000000000001	/* 0000000000000000000000000000000000000000000000000000000000000001 */
-#define INNER_ZERO	0xFFFFFFFFFFFFFF00	/* 1111111111111111111111111111111111111111111111111111111100000000 */
-#define OUTER_COUNT	0x0000000000FFFF00	/* 0000000000000000000000000000000000000000111111111111111100000000 */
-#define OUTER_ONE	0x0000000000000100	/* 0000000000000000000000000000000000000001000000000000000000000000 */
-#define OUTER_ZERO	0xFFFFFFFFFF0000FF	/* 1111111111111111111111111111111111111111000000000000000011111111 */
-#define DELTA_COUNT	0x0000000000000008	/* 0000000000000000000000000000000000000000000000000000000000001000 */
-#define DELTA_MANTISSA	0x0000000000000034	/* 0000000000000000000000000000000000000000000000000000000000110100 */
-#define MAX_MANTISSA	0x000FFFFFFFFFFFFF	/* 0000000000001111111111111111111111111111111111111111111111111111 */
-#define SEED		0x38B1D098F2C40E5D
-#else
-/* 32-bit masks */
-#define RULE30		0x0000001E		/* 00000000000000000000000000011110 */
-#define RULE110		0x0000006E		/* 00000000000000000000000001101110 */
-#define RULE10		0x0000000A		/* 00000000000000000000000000001010 */
-#define RULE90		0x0000005A		/* 00000000000000000000000001011010 */
-
-#define CELL_MASK	0x00000007		/* 00000000000000000000000000000111 */
-#define CENTER_MASK	0x00010000		/* 00000000000000010000000000000000 */
-#define DELTA_CENTER	0x00000010		/* 00000000000000000000000000010000 */
-#define RHS_ONE		0x00000001		/* 00000000000000000000000000000001 */
-#define LHS_ONE		0x80000000		/* 10000000000000000000000000000000 */
-#define LHS_ZERO	0x7FFFFFFF		/* 01111111111111111111111111111111 */
-#define INNER_COUNT	0x000000FF		/* 00000000000000000000000011111111 */
-#define INNER_ONE	0x00000001		/* 00000000000000000000000000000001 */
-#define INNER_ZERO	0xFFFFFF00		/* 11111111111111111111111100000000 */
-#define OUTER_COUNT	0x00FFFF00		/* 00000000111111111111111100000000 */
-#define OUTER_ONE	0x00000100		/* 00000001000000000000000000000000 */
-#define OUTER_ZERO	0xFF0000FF		/* 11111111000000000000000011111111 */
-#define DELTA_COUNT	0x00000008		/* 00000000000000000000000000001000 */
-#define DELTA_MANTISSA	0x0000000000000034	/* 0000000000000000000000000000000000000000000000000000000000110100 */
-#define MAX_MANTISSA	0x00000000FFFFFFFF	/* 0000000000000000000000000000000011111111111111111111111111111111 */
-#define SEED		0xF2C40E5D
-#endif /* WORDSIZE == 64 */
+
+#define _GNU_SOURCE
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "rule30.rng.h"
+#include "rule30.pool.h"
+#include "rule30.cone.h"
+
+#define BUFFER_BYTES	(1 << 20)	/* per output buffer, also the pipe size asked for */
+#define PAGE_BYTES	4096
+#define NUM_RANDOM	1000000		/* numbers printed in text mode, or words by default in binary */
 
 /* debugging routine since printf still doesn't have binary output in the year 2005 */
 void print_binary(unsigned long int in) {
@@ -130,287 +101,231 @@ void print_binary_double(double in_double) {
 
 }
 
-#if WORDSIZE == 64 /* 64-bit */
-
-double rule30_rng(unsigned long int seed) {
-
-	register unsigned long int rule = RULE30;	/* the rule to enforce */
-	register unsigned long int in_reg1 = 0,		/* input registers */
-				   in_reg2 = 0,
-				   in_reg3 = 0,
-				   in_reg4 = 0,
-				   in_reg5 = 0,
-				   in_reg6 = 0,
-				   in_reg7 = 0;
-	register unsigned long int out_reg1 = 0,	/* output registers */
-				   out_reg2 = 0,
-				   out_reg3 = 0,
-				   out_reg4 = 0,
-				   out_reg5 = 0,
-				   out_reg6 = 0,
-				   out_reg7 = 0;
-	register unsigned long int mp = 0;		/* multi-purpose register:					*/
-							/* 	- the right-most 8 bits are for the inner loop counter	*/
-							/* 	- the next 16 bits are for the outer loop counter	*/
-							/* 	- the left-most bit is for carries			*/
-	static unsigned long int last_reg1,		/* static memory addrs to store results from the current run */
-				 last_reg2,
-				 last_reg3,
-				 last_reg4,
-				 last_reg5,
-				 last_reg6,
-				 last_reg7;
-	double random_result = 0;			/* return a double from 0.0 to 1.0 */
-	unsigned long int random_result_int = 0;	/* integer version of the above for boolean ops */
-
-	/* start with initial config */
-	if(seed) {
-		in_reg1 = in_reg2 = in_reg3 = in_reg4 = in_reg5 = in_reg6 = in_reg7 = seed;
-	}
-	else {
-#ifdef DEBUG
-		/* set up the canonical state for debugging */
-		in_reg4 = CENTER_MASK;
+/* the stream as little-endian words of width bits, in place - 32-bit words high half first */
+void little_endian(uint64_t *buf, size_t n, int width) {
+
+	size_t i;
+
+	for(i = 0; i < n; i++) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		*(buf + i) = __builtin_bswap64(*(buf + i));
+		if(width == 32)
+			*(buf + i) = (*(buf + i) << 32) | (*(buf + i) >> 32);
 #else
-		/* already seeded - restore state from memory */
-		in_reg1 = last_reg1;
-		in_reg2 = last_reg2;
-		in_reg3 = last_reg3;
-		in_reg4 = last_reg4;
-		in_reg5 = last_reg5;
-		in_reg6 = last_reg6;
-		in_reg7 = last_reg7;
-#endif /* DEBUG */
+		if(width == 32)
+			*(buf + i) = (*(buf + i) << 32) | (*(buf + i) >> 32);
+#endif /* __BYTE_ORDER__ */
 	}
 
-#ifdef DEBUG
-	/* the current cellular automata rule being imposed */
-	printf("current rule: %d\n\n", rule);
-
-	/* print initial line */
-	print_binary(in_reg4); printf("\n");
-#endif /* DEBUG */
-
-	for((mp &= OUTER_ZERO); ((mp & OUTER_COUNT) >> DELTA_COUNT) < DELTA_MANTISSA; mp += OUTER_ONE) {/* <-- notice the fact that the increment here */
-		for((mp &= INNER_ZERO); (mp & INNER_COUNT) < WORDSIZE; mp += INNER_ONE) {		/* will blow away the low-order bits doesn't matter */
-
-			/* mask off first three bits and compare with rule */
-			/* set the output register bit appropriately */
-			out_reg1 |= ((rule >> (in_reg1 & CELL_MASK)) & RHS_ONE) << (mp & INNER_COUNT);
-			out_reg2 |= ((rule >> (in_reg2 & CELL_MASK)) & RHS_ONE) << (mp & INNER_COUNT);
-			out_reg3 |= ((rule >> (in_reg3 & CELL_MASK)) & RHS_ONE) << (mp & INNER_COUNT);
-			out_reg4 |= ((rule >> (in_reg4 & CELL_MASK)) & RHS_ONE) << (mp & INNER_COUNT);
-			out_reg5 |= ((rule >> (in_reg5 & CELL_MASK)) & RHS_ONE) << (mp & INNER_COUNT);
-			out_reg6 |= ((rule >> (in_reg6 & CELL_MASK)) & RHS_ONE) << (mp & INNER_COUNT);
-			out_reg7 |= ((rule >> (in_reg7 & CELL_MASK)) & RHS_ONE) << (mp & INNER_COUNT);
-
-			/* rotate all input registers one bit to the right, preserve carry */
-			mp &= LHS_ZERO;							/* clear the carry bit */
-			mp |= ((in_reg7 & RHS_ONE) << (WORDSIZE - 1));			/* set carry bit if needed */
-			in_reg7 >>= RHS_ONE;
-			in_reg7 |= ((in_reg6 & RHS_ONE) << (WORDSIZE - 1));
-			in_reg6 >>= RHS_ONE;
-			in_reg6 |= ((in_reg5 & RHS_ONE) << (WORDSIZE - 1));
-			in_reg5 >>= RHS_ONE;
-			in_reg5 |= ((in_reg4 & RHS_ONE) << (WORDSIZE - 1));
-			in_reg4 >>= RHS_ONE;
-			in_reg4 |= ((in_reg3 & RHS_ONE) << (WORDSIZE - 1));
-			in_reg3 >>= RHS_ONE;
-			in_reg3 |= ((in_reg2 & RHS_ONE) << (WORDSIZE - 1));
-			in_reg2 >>= RHS_ONE;
-			in_reg2 |= ((in_reg1 & RHS_ONE) << (WORDSIZE - 1));
-			in_reg1 >>= RHS_ONE;
-			in_reg1 |= mp & LHS_ONE;
+}
 
+/* write len bytes from buf to fd, through vmsplice() if splicing - returns -1 on error */
+int output(int fd, char *buf, size_t len, int splicing) {
+
+	struct iovec iov;
+	ssize_t done;
+
+	while(len) {
+
+#ifdef __linux__
+		if(splicing) {
+			iov.iov_base = buf;
+			iov.iov_len = len;
+			done = vmsplice(fd, &iov, 1, 0);
+		} else
+#endif /* __linux__ */
+			done = write(fd, buf, len);
+
+		if(done < 0) {
+			if(errno == EINTR)
+				continue;
+			return(-1);
 		}
 
-		/* now must rotate output registers one bit to the left */
-		mp &= LHS_ZERO;								/* clear the carry bit */
-		mp |= out_reg1 & LHS_ONE;						/* set the carry bit if needed */
-		out_reg1 <<= RHS_ONE;
-		out_reg1 |= ((out_reg2 & LHS_ONE) >> (WORDSIZE - 1));
-		out_reg2 <<= RHS_ONE;
-		out_reg2 |= ((out_reg3 & LHS_ONE) >> (WORDSIZE - 1));
-		out_reg3 <<= RHS_ONE;
-		out_reg3 |= ((out_reg4 & LHS_ONE) >> (WORDSIZE - 1));
-		out_reg4 <<= RHS_ONE;
-		out_reg4 |= ((out_reg5 & LHS_ONE) >> (WORDSIZE - 1));
-		out_reg5 <<= RHS_ONE;
-		out_reg5 |= ((out_reg6 & LHS_ONE) >> (WORDSIZE - 1));
-		out_reg6 <<= RHS_ONE;
-		out_reg6 |= ((out_reg7 & LHS_ONE) >> (WORDSIZE - 1));
-		out_reg7 <<= RHS_ONE;
-		out_reg7 |=  ((mp & LHS_ONE) >> (WORDSIZE - 1));
-
-		/* set output bits of random number */
-		random_result_int |= ((out_reg4 & CENTER_MASK) >> DELTA_CENTER) << ((DELTA_MANTISSA - 1) - ((mp & OUTER_COUNT) >> DELTA_COUNT));
-
-#ifdef DEBUG
-		/* give visual output */
-		print_binary(out_reg4); printf("\t%d\n", (mp & OUTER_COUNT) >> DELTA_COUNT);
-#endif /* DEBUG */
-
-		/* swap the input and output registers */
-		in_reg1 = out_reg1;
-		in_reg2 = out_reg2;
-		in_reg3 = out_reg3;
-		in_reg4 = out_reg4;
-		in_reg5 = out_reg5;
-		in_reg6 = out_reg6;
-		in_reg7 = out_reg7;
-
-		/* clear output registers */
-		out_reg1 = out_reg2 = out_reg3 = out_reg4 = out_reg5 = out_reg6 = out_reg7 = 0;
+		buf += done;
+		len -= done;
 
 	}
-	/* save last state point to static memory */
-	last_reg1 = in_reg1;
-	last_reg2 = in_reg2;
-	last_reg3 = in_reg3;
-	last_reg4 = in_reg4;
-	last_reg5 = in_reg5;
-	last_reg6 = in_reg6;
-	last_reg7 = in_reg7;
-
-	random_result = (double)random_result_int;
-	random_result /= (double)MAX_MANTISSA;		/* ensure that result is normalized from 0 to 1 */
-	return(random_result);
+
+	return(0);
 
 }
 
-#else /* 32-bit */
-
-double rule30_rng(unsigned long int seed) {
-
-	register unsigned long int rule = RULE30;	/* the rule to enforce */
-	register unsigned long int in_reg1 = 0,		/* input registers */
-				   in_reg2 = 0,
-				   in_reg3 = 0;
-	register unsigned long int out_reg1 = 0,	/* output registers */
-				   out_reg2 = 0,
-				   out_reg3 = 0;
-	register unsigned long int mp = 0;		/* multi-purpose register:					*/
-							/* 	- the right-most 8 bits are for the inner loop counter	*/
-							/* 	- the next 16 bits are for the outer loop counter	*/
-							/* 	- the left-most bit is for carries			*/
-	static unsigned long int last_reg1,		/* static memory addrs to store results from the current run */
-				 last_reg2,
-				 last_reg3;
-
-	double random_result = 0;			/* return a double from 0.0 to 1.0 */
-	unsigned long long int random_result_int = 0;	/* integer version of the above for boolean ops */
-
-	/* start with initial config */
-	if(seed) {
-		in_reg1 = in_reg2 = in_reg3 = seed;
-	}
-	else {
-#ifdef DEBUG
-		/* set up the canonical state for debugging */
-		in_reg2 = CENTER_MASK;
-#else
-		/* already seeded - restore state from memory */
-		in_reg1 = last_reg1;
-		in_reg2 = last_reg2;
-		in_reg3 = last_reg3;
-#endif /* DEBUG */
+/* stream raw words to stdout until limit bytes have been written, or for ever if unbounded */
+void binary(struct rule30_rng_state *state, int width, int taps_mode, int cone_mode, int workers, unsigned long int seed, unsigned long long limit, int unbounded) {
+
+	struct rule30_taps taps;
+	struct rule30_pool pool;
+	struct rule30_cone *cone = NULL;
+	struct stat st;
+	uint64_t *buffer[2];
+	size_t words = BUFFER_BYTES / sizeof(uint64_t), len, i;
+	int splicing = 0, current = 0, ring = 0;
+
+	/* a reader that exits is the normal end of -u - see it as EPIPE rather than be killed */
+	signal(SIGPIPE, SIG_IGN);
+
+	if(posix_memalign((void **)&buffer[0], PAGE_BYTES, BUFFER_BYTES) || posix_memalign((void **)&buffer[1], PAGE_BYTES, BUFFER_BYTES)) {
+		fprintf(stderr, "couldn't allocate output buffers\n");
+		exit(1);
 	}
 
-#ifdef DEBUG
-	/* the current cellular automata rule being imposed */
-	printf("current rule: %d\n\n", rule);
-
-	/* print initial line */
-	print_binary(in_reg1); print_binary(in_reg2); print_binary(in_reg3); printf("\n");
-#endif /* DEBUG */
-
-	for((mp &= OUTER_ZERO); ((mp & OUTER_COUNT) >> DELTA_COUNT) < DELTA_MANTISSA; mp += OUTER_ONE) {/* <-- notice the fact that the increment here */
-		for((mp &= INNER_ZERO); (mp & INNER_COUNT) < WORDSIZE; mp += INNER_ONE) {		/* will blow away the low-order bits doesn't matter */
-
-			/* mask off first three bits and compare with rule */
-			/* set the output register bit appropriately */
-			out_reg1 |= ((rule >> (in_reg1 & CELL_MASK)) & RHS_ONE) << (mp & INNER_COUNT);
-			out_reg2 |= ((rule >> (in_reg2 & CELL_MASK)) & RHS_ONE) << (mp & INNER_COUNT);
-			out_reg3 |= ((rule >> (in_reg3 & CELL_MASK)) & RHS_ONE) << (mp & INNER_COUNT);
-
-			/* rotate all input registers one bit to the right, preserve carry */
-			mp &= LHS_ZERO;							/* clear the carry bit */
-			mp |= ((in_reg3 & RHS_ONE) << (WORDSIZE - 1));			/* set carry bit if needed */
-			in_reg3 >>= RHS_ONE;
-			in_reg3 |= ((in_reg2 & RHS_ONE) << (WORDSIZE - 1));
-			in_reg2 >>= RHS_ONE;
-			in_reg2 |= ((in_reg1 & RHS_ONE) << (WORDSIZE - 1));
-			in_reg1 >>= RHS_ONE;
-			in_reg1 |= mp & LHS_ONE;
+#ifdef __linux__
+	/* splice only if the pipe can hold a whole buffer, so that the other one is free to refill */
+	if(!fstat(STDOUT_FILENO, &st) && S_ISFIFO(st.st_mode))
+		splicing = (fcntl(STDOUT_FILENO, F_SETPIPE_SZ, BUFFER_BYTES) >= BUFFER_BYTES);
+#endif /* __linux__ */
 
+	if(taps_mode) {
+		rule30_taps_default(&taps);
+		rule30_rng_init_full(state, seed);
+	}
+	if(cone_mode) {
+		cone = (struct rule30_cone *)malloc(sizeof(struct rule30_cone));
+		if(!cone) {
+			fprintf(stderr, "couldn't allocate the light-cone tables\n");
+			exit(1);
 		}
+		rule30_cone_init(cone, RULE30);
+	}
+	if(workers && rule30_pool_start(&pool, workers, seed)) {
+		fprintf(stderr, "couldn't start %d worker threads\n", workers);
+		exit(1);
+	}
 
-		/* now must rotate output registers one bit to the left */
-		mp &= LHS_ZERO;								/* clear the carry bit */
-		mp |= out_reg1 & LHS_ONE;						/* set the carry bit if needed */
-		out_reg1 <<= RHS_ONE;
-		out_reg1 |= ((out_reg2 & LHS_ONE) >> (WORDSIZE - 1));
-		out_reg2 <<= RHS_ONE;
-		out_reg2 |= ((out_reg3 & LHS_ONE) >> (WORDSIZE - 1));
-		out_reg3 <<= RHS_ONE;
-		out_reg3 |=  ((mp & LHS_ONE) >> (WORDSIZE - 1));
+	do {
+
+		if(workers) {
+			for(i = 0; i < words; i += POOL_BLOCK) {
+				memcpy(buffer[current] + i, rule30_pool_acquire(&pool, ring), POOL_BLOCK*sizeof(uint64_t));
+				rule30_pool_release(&pool, ring);
+				ring = (ring + 1) % workers;
+			}
+		} else if(taps_mode)
+			rule30_rng_fill_u64_taps_dispatch(state, &taps, buffer[current], words);
+		else if(cone_mode)
+			rule30_cone_fill_u64(cone, state, buffer[current], words);
+		else
+			rule30_rng_fill_u64_dispatch(state, buffer[current], words);
+		little_endian(buffer[current], words, width);
+
+		len = BUFFER_BYTES;
+		if(!unbounded && (limit < len))
+			len = limit;
+		if(output(STDOUT_FILENO, (char *)buffer[current], len, splicing)) {
+			if(errno == EPIPE)
+				break;	/* the reader has gone away */
+			perror("write");
+			exit(1);
+		}
+		if(!unbounded)
+			limit -= len;
+
+		current ^= 1;
 
-                /* set output bits of random sequence */
-                random_result_int |= ((out_reg2 & CENTER_MASK) >> DELTA_CENTER) << ((DELTA_MANTISSA - 1) - ((mp & OUTER_COUNT) >> DELTA_COUNT));
+	} while(unbounded || limit);
 
-#ifdef DEBUG
-		/* give visual output */
-		print_binary(out_reg1); print_binary(out_reg2); print_binary(out_reg3); printf("\t%d\n", (mp & OUTER_COUNT) >> DELTA_COUNT);
-#endif /* DEBUG */
+	if(workers)
+		rule30_pool_stop(&pool);
+	free(cone);
+	free(buffer[0]);
+	free(buffer[1]);
 
-		/* swap the input and output registers */
-		in_reg1 = out_reg1;
-		in_reg2 = out_reg2;
-		in_reg3 = out_reg3;
+}
 
-		/* clear the output registers */
-		out_reg1 = out_reg2 = out_reg3 = 0;
+void usage(char *progname) {
 
-	}
-	/* save the last state point in static memory */
-	last_reg1 = in_reg1;
-	last_reg2 = in_reg2;
-	last_reg3 = in_reg3;
+	fprintf(stderr, "usage: %s [-s seed] [-u] [-b 64|32 [-c bytes] [-t|-l] [-j workers]]\n", progname);
+	fprintf(stderr, "\t-b\traw little-endian binary words of 64 or 32 bits instead of text\n");
+	fprintf(stderr, "\t-c\tbytes of binary output (k, M and G suffixes allowed)\n");
+	fprintf(stderr, "\t-u\tunbounded, stream until the reader goes away\n");
+	fprintf(stderr, "\t-t\tharvest the default tap set from a fully seeded lattice\n");
+	fprintf(stderr, "\t-l\tgenerate the center column with the light-cone table engine\n");
+	fprintf(stderr, "\t-j\tgenerate with this many worker threads (implies -t)\n");
+	exit(1);
 
-	random_result = (double)random_result_int;
-	random_result /= (double)MAX_MANTISSA;		/* ensure that result is normalized from 0 to 1 */
-	return(random_result);
+}
+
+/* a byte count with an optional k, M or G suffix */
+unsigned long long byte_count(char *arg) {
+
+	char *end;
+	unsigned long long count = strtoull(arg, &end, 0);
+
+	switch(*end) {
+		case 'k':
+			return(count << 10);
+		case 'M':
+			return(count << 20);
+		case 'G':
+			return(count << 30);
+		case '\0':
+			return(count);
+		default:
+			return(0);
+	}
 
 }
-#endif /* WORDSIZE == 64 */
 
-int main() {
+int main(int argc, char **argv) {
 
-	int i;
+	int i, c;
+	int width = 0, unbounded = 0, taps_mode = 0, cone_mode = 0, workers = 0;
+	unsigned long long limit = 0;
 	unsigned long int seed = 1234523;
+	struct rule30_rng_state state;
 	double rand;
-	clock_t initial_time, final_time;
-
-	rule30_rng(seed);
-#ifdef BENCHMARK
-	while(1) {
 
-		initial_time = final_time = clock();
-		for(i = 0; (final_time - initial_time) / CLOCKS_PER_SEC < 1.0; i++) {
-			final_time = clock();
-			rand = rule30_rng(0);
+	CA_STATS_INSTALL(SIGUSR1);
+
+	while((c = getopt(argc, argv, "s:b:c:utlj:")) != -1) {
+		switch(c) {
+			case 's':
+				seed = strtoul(optarg, NULL, 0);
+				break;
+			case 'b':
+				width = atoi(optarg);
+				break;
+			case 'c':
+				limit = byte_count(optarg);
+				if(!limit) usage((char *)argv[0]);
+				break;
+			case 'u':
+				unbounded = 1;
+				break;
+			case 't':
+				taps_mode = 1;
+				break;
+			case 'l':
+				cone_mode = 1;
+				break;
+			case 'j':
+				workers = atoi(optarg);
+				if(workers < 1) usage((char *)argv[0]);
+				break;
+			default:
+				usage((char *)argv[0]);
 		}
-		fprintf(stderr, "# performance: %d doubles/sec\n", i);
 	}
-#else
-	for(i = 0; i < 1000000; i++) {
-		rand = rule30_rng(0);
-		printf("%.16f\n", rand);
+	if(width && (width != 64) && (width != 32)) usage((char *)argv[0]);
+	if(!width && (limit || taps_mode || cone_mode || workers)) usage((char *)argv[0]);
+	if(cone_mode && (taps_mode || workers)) usage((char *)argv[0]);
+	if(!seed || (optind < argc)) usage((char *)argv[0]);
+
+	/* seed the stream - as with the original rule30_rng(seed) the first number is dropped */
+	rule30_rng_init(&state, seed);
+	rule30_rng_next(&state);
+	if(width) {
+		if(!limit)
+			limit = (unsigned long long)NUM_RANDOM*sizeof(uint64_t);
+		binary(&state, width, taps_mode || workers, cone_mode, workers, seed, limit, unbounded);
+	} else {
+		for(i = 0; i < NUM_RANDOM; i += !unbounded) {
+			rand = rule30_rng_next(&state);
+			printf("%.16f\n", rand);
+		}
 	}
-#endif /* BENCHMARK */
 
-	exit(0); /* NOT REACHED */
+	exit(0);
 
 }
-
-
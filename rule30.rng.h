@@ -0,0 +1,577 @@
+/************************************************************************/
+/* Cellular automata rule 30-derived pseudo random number generator	*/
+/*									*/
+/* Reentrant interface to the generator.  All of the state of a stream	*/
+/* lives in a struct rule30_rng_state owned by the caller, so any	*/
+/* number of independent streams may be run side by side - typically	*/
+/* one per worker thread, with no locking and no shared cache lines	*/
+/* since each state is aligned to a line of its own.			*/
+/*									*/
+/*	rule30_rng_init()		seed a stream			*/
+/*	rule30_rng_init_full()		seed the whole array		*/
+/*	rule30_rng_next()		next double from a stream	*/
+/*	rule30_rng_fill_u64()		bulk 64-bit words from a stream	*/
+/*	rule30_rng_fill_double()	bulk doubles from a stream	*/
+/*	rule30_rng_advance()		skip generations of a stream	*/
+/*	rule30_rng_fill_u64_taps()	bulk words, several taps per	*/
+/*					generation			*/
+/*	rule30_rng_fill_*_dispatch()	the bulk calls, compiled for	*/
+/*					each instruction set		*/
+/*									*/
+/* The bulk calls keep the register array in registers for the whole	*/
+/* batch and write straight into the caller's buffer, which is much	*/
+/* cheaper than restoring and saving the state on every number.  Per	*/
+/* generation the scalar step is the one rule30_rng_next() runs; the	*/
+/* dispatched bulk calls step the whole lattice in vectors instead (two	*/
+/* with AVX2, one with AVX-512), which the rng_next and			*/
+/* rng_dispatch_double rows of rule30bench compare.			*/
+/*									*/
+/* The original rule30_rng(seed) call is kept on top of a single static	*/
+/* stream for existing callers; it is not reentrant.			*/
+/*									*/
+/* @2005 Jonathan Belof							*/
+/************************************************************************/
+
+#ifndef RULE30_RNG_H
+#define RULE30_RNG_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ca.h"
+#include "ca.dispatch.h"
+#include "ca.stats.h"
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif /* __x86_64__ */
+
+/* the register array is of 64-bit words */
+#define WORDSIZE	64
+
+/* 64-bit masks */
+#define RULE30		0x000000000000001E	/* 0000000000000000000000000000000000000000000000000000000000011110 */
+#define RULE110		0x000000000000006E	/* 0000000000000000000000000000000000000000000000000000000001101110 */
+#define RULE10		0x000000000000000A	/* 0000000000000000000000000000000000000000000000000000000000001010 */
+#define RULE90		0x000000000000005A	/* 0000000000000000000000000000000000000000000000000000000001011010 */
+
+#define CELL_MASK	0x0000000000000007	/* 0000000000000000000000000000000000000000000000000000000000000111 */
+#define CENTER_MASK	0x0000000100000000	/* 0000000000000000000000000000000100000000000000000000000000000000 */
+#define DELTA_CENTER	0x0000000000000020	/* 0000000000000000000000000000000000000000000000000000000000100000 */
+#define RHS_ONE		0x0000000000000001	/* 0000000000000000000000000000000000000000000000000000000000000001 */
+#define LHS_ONE		0x8000000000000000	/* 1000000000000000000000000000000000000000000000000000000000000000 */
+#define LHS_ZERO	0x7FFFFFFFFFFFFFFF	/* 0111111111111111111111111111111111111111111111111111111111111111 */
+#define INNER_COUNT	0x00000000000000FF	/* 0000000000000000000000000000000000000000000000000000000011111111 */
+#define INNER_ONE	0x0000000000000001	/* 0000000000000000000000000000000000000000000000000000000000000001 */
+#define INNER_ZERO	0xFFFFFFFFFFFFFF00	/* 1111111111111111111111111111111111111111111111111111111100000000 */
+#define OUTER_COUNT	0x0000000000FFFF00	/* 0000000000000000000000000000000000000000111111111111111100000000 */
+#define OUTER_ONE	0x0000000000000100	/* 0000000000000000000000000000000000000001000000000000000000000000 */
+#define OUTER_ZERO	0xFFFFFFFFFF0000FF	/* 1111111111111111111111111111111111111111000000000000000011111111 */
+#define DELTA_COUNT	0x0000000000000008	/* 0000000000000000000000000000000000000000000000000000000000001000 */
+#define DELTA_MANTISSA	0x0000000000000034	/* 0000000000000000000000000000000000000000000000000000000000110100 */
+#define MAX_MANTISSA	0x000FFFFFFFFFFFFF	/* 0000000000001111111111111111111111111111111111111111111111111111 */
+#define SEED		0x38B1D098F2C40E5D
+
+/* registers in the circular array - the lattice is RNG_REGS*WORDSIZE cells wide and may be	*/
+/* set at compile time, e.g. -DRNG_REGS=2 for a 128-cell lattice on latency critical paths	*/
+/* or -DRNG_REGS=16 for 1024 cells where a long period matters.  Each width is a stream	*/
+/* of its own; the classic stream is 7 registers.						*/
+#ifndef RNG_REGS
+#define RNG_REGS	7
+#endif /* RNG_REGS */
+
+CA_LATTICE_DEFINE(rng_lattice, unsigned long int, RNG_REGS, WORDSIZE)
+
+#ifdef DEBUG
+void print_binary(unsigned long int in);
+#endif /* DEBUG */
+
+/* all of the state of one stream - aligned so that streams owned by different	*/
+/* threads never share a cache line						*/
+struct rule30_rng_state {
+
+	unsigned long int reg[RNG_REGS];	/* the circular register array, left to right */
+
+} __attribute__((aligned(64)));
+
+/* seed a stream - every register of the array is loaded with the (non-zero) seed */
+static inline void rule30_rng_init(struct rule30_rng_state *state, unsigned long int seed) {
+
+	int i;
+
+	for(i = 0; i < RNG_REGS; i++)
+		state->reg[i] = seed;
+
+	CA_STATS_RESEED();
+
+}
+
+/* seed a stream with every register loaded differently - the words are drawn from the	*/
+/* seed by a splitmix64 sequence.  rule30_rng_init() copies the seed into every register,	*/
+/* which leaves the lattice periodic with a period of one register: all registers stay	*/
+/* identical forever and only WORDSIZE cells are effectively in play.  That is harmless	*/
+/* for the classic center column but any tap set must be run from this seeding.		*/
+static inline void rule30_rng_init_full(struct rule30_rng_state *state, unsigned long int seed) {
+
+	unsigned long long int z = seed, x;
+	int i;
+
+	for(i = 0; i < RNG_REGS; i++) {
+		z += 0x9E3779B97F4A7C15ULL;
+		x = z;
+		x = (x ^ (x >> 30))*0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27))*0x94D049BB133111EBULL;
+		state->reg[i] = (unsigned long int)(x ^ (x >> 31));
+	}
+
+	CA_STATS_RESEED();
+
+}
+
+/* a set of columns read out of the lattice on every generation - the classic generator	*/
+/* keeps only the center cell, tapping several well separated columns gives that many	*/
+/* random bits for the same amount of CA work						*/
+struct rule30_taps {
+
+	unsigned long int mask[RNG_REGS];	/* tapped cells of each register */
+	int count;				/* number of taps, i.e. bits per generation */
+
+};
+
+/* tap the given columns, numbered 0 (left end of the array) to RNG_REGS*WORDSIZE - 1	*/
+/* - returns -1 for a column out of range, a repeated column or more than 64 taps	*/
+static inline int rule30_taps_init(struct rule30_taps *taps, const int *columns, int count) {
+
+	int i, reg;
+	unsigned long int cell;
+
+	if((count < 1) || (count > 64))
+		return(-1);
+
+	for(i = 0; i < RNG_REGS; i++)
+		taps->mask[i] = 0;
+
+	for(i = 0; i < count; i++) {
+
+		if((*(columns + i) < 0) || (*(columns + i) >= RNG_REGS*WORDSIZE))
+			return(-1);
+
+		reg = *(columns + i) / WORDSIZE;
+		cell = LHS_ONE >> (*(columns + i) % WORDSIZE);
+		if(taps->mask[reg] & cell)
+			return(-1);
+		taps->mask[reg] |= cell;
+
+	}
+	taps->count = count;
+
+	return(0);
+
+}
+
+/* the default tap set: the center cell of every register, i.e. RNG_REGS columns spaced	*/
+/* a full register (WORDSIZE cells) apart, one of which is the classic center column.	*/
+/* See rule30.quality.c for the statistics of this against the single center tap.	*/
+static inline void rule30_taps_default(struct rule30_taps *taps) {
+
+	int i;
+
+	for(i = 0; i < RNG_REGS; i++)
+		taps->mask[i] = CENTER_MASK;
+	taps->count = RNG_REGS;
+
+}
+
+/* the register array as a local, so that the compiler keeps the lattice in registers for	*/
+/* as long as a call runs - state is only touched on entry and exit				*/
+#define RNG_REGISTERS		rng_lattice lattice
+#define RNG_RESTORE(state)	memcpy(lattice.reg, (state)->reg, sizeof(lattice.reg))
+#define RNG_SAVE(state)		memcpy((state)->reg, lattice.reg, sizeof(lattice.reg))
+#define RNG_GENERATION(rule)	rng_lattice_step(&lattice, rule)
+
+/* the designated center cell of the current generation */
+#define RNG_CENTER_BIT		((lattice.reg[RNG_REGS / 2] & CENTER_MASK) >> DELTA_CENTER)
+
+#define RNG_PRINT()		print_binary(lattice.reg[RNG_REGS / 2])
+
+#define RNG_HARVEST(taps, bits)	for(reg_index = 0; reg_index < RNG_REGS; reg_index++)				\
+					RNG_TAP(lattice.reg[reg_index], (taps)->mask[reg_index], bits)
+
+/* shift the tapped cells of a register into bits, lowest tapped cell first */
+#define RNG_TAP(reg, mask, bits)	for(tap = (mask); tap; tap &= tap - RHS_ONE)					\
+						bits = (bits << RHS_ONE) | ((reg & tap & -tap) ? RHS_ONE : 0)
+
+/* the 52 mantissa bits as a double in [0, 1) - with the exponent of 1.0 the bits give a	*/
+/* number in [1, 2) exactly, so one subtraction replaces the divide by MAX_MANTISSA	*/
+/* (which returned 1.0 for an all-ones mantissa)					*/
+#define ONE_EXPONENT		0x3FF0000000000000ULL
+#define RNG_MANTISSA_DOUBLE(m)	(((union { unsigned long long int i; double d; }){ .i = ONE_EXPONENT | (m) }).d - 1.0)
+
+static inline double rule30_rng_next(struct rule30_rng_state *state) {
+
+	register unsigned long int rule = RULE30;	/* the rule to enforce */
+	RNG_REGISTERS;
+	register unsigned long int mp = 0;		/* multi-purpose register:					*/
+							/* 	- bits 8 through 23 are for the generation counter	*/
+	double random_result = 0;			/* return a double from 0.0 up to 1.0 */
+	unsigned long long int random_result_int = 0;	/* integer version of the above for boolean ops */
+
+	/* restore the stream state */
+	RNG_RESTORE(state);
+	CA_STATS_START(stats_start);
+
+#ifdef DEBUG
+	/* the current cellular automata rule being imposed */
+	printf("current rule: %d\n\n", (int)rule);
+
+	/* print initial line */
+	RNG_PRINT(); printf("\n");
+#endif /* DEBUG */
+
+	for((mp &= OUTER_ZERO); ((mp & OUTER_COUNT) >> DELTA_COUNT) < DELTA_MANTISSA; mp += OUTER_ONE) {
+
+		RNG_GENERATION(rule);
+
+		/* set output bits of random number */
+		random_result_int |= (unsigned long long int)RNG_CENTER_BIT << ((DELTA_MANTISSA - 1) - ((mp & OUTER_COUNT) >> DELTA_COUNT));
+
+#ifdef DEBUG
+		/* give visual output */
+		RNG_PRINT(); printf("\t%d\n", (int)((mp & OUTER_COUNT) >> DELTA_COUNT));
+#endif /* DEBUG */
+
+	}
+
+	/* save last state point back to the stream */
+	RNG_SAVE(state);
+	CA_STATS_END(CA_PHASE_RNG, stats_start, DELTA_MANTISSA, DELTA_MANTISSA);
+
+	random_result = RNG_MANTISSA_DOUBLE(random_result_int);	/* normalized from 0 to 1, excluding 1 */
+	return(random_result);
+
+}
+
+/* advance the stream by generations without producing any output - each double of	*/
+/* rule30_rng_next() is DELTA_MANTISSA generations and each word of rule30_rng_fill_u64()	*/
+/* is 64, so this skips whole numbers of either						*/
+static inline void rule30_rng_advance(struct rule30_rng_state *state, uint64_t generations) {
+
+	register unsigned long int rule = RULE30;	/* the rule to enforce */
+	RNG_REGISTERS;
+	uint64_t i;
+
+	RNG_RESTORE(state);
+	CA_STATS_START(stats_start);
+
+	for(i = 0; i < generations; i++)
+		RNG_GENERATION(rule);
+
+	RNG_SAVE(state);
+	CA_STATS_END(CA_PHASE_RNG, stats_start, generations, 0);
+
+}
+
+/* bulk call - fill buf with the next n 64-bit words of the stream, one center bit per	*/
+/* generation with the first generation in the most significant bit			*/
+static inline void rule30_rng_fill_u64(struct rule30_rng_state *state, uint64_t *buf, size_t n) {
+
+	register unsigned long int rule = RULE30;	/* the rule to enforce */
+	RNG_REGISTERS;
+	register unsigned long long int random_result_int;
+	size_t i;
+	int j;
+
+	RNG_RESTORE(state);
+	CA_STATS_START(stats_start);
+
+	for(i = 0; i < n; i++) {
+
+		random_result_int = 0;
+		for(j = 0; j < 64; j++) {
+			RNG_GENERATION(rule);
+			random_result_int = (random_result_int << RHS_ONE) | RNG_CENTER_BIT;
+		}
+		*(buf + i) = random_result_int;
+
+	}
+
+	RNG_SAVE(state);
+	CA_STATS_END(CA_PHASE_RNG, stats_start, 64*n, 64*n);
+	CA_STATS_BATCH(n);
+
+}
+
+/* bulk call as above, but reading taps->count bits per generation from the tap set -	*/
+/* with rule30_taps_default() that is RNG_REGS times fewer generations per word.  Bits	*/
+/* of the last generation that do not fit into buf are dropped.  The stream must have	*/
+/* been seeded with rule30_rng_init_full(), see above.					*/
+static inline void rule30_rng_fill_u64_taps(struct rule30_rng_state *state, const struct rule30_taps *taps, uint64_t *buf, size_t n) {
+
+	register unsigned long int rule = RULE30;	/* the rule to enforce */
+	RNG_REGISTERS;
+	register unsigned long long int random_result_int = 0;
+	register unsigned long long int generation_bits;
+	unsigned long int tap;
+	int reg_index;
+	int count = taps->count;			/* bits per generation */
+	int space = 64;					/* bits still free in random_result_int */
+	size_t i = 0;
+
+	RNG_RESTORE(state);
+	CA_STATS_START(stats_start);
+
+	while(i < n) {
+
+		RNG_GENERATION(rule);
+
+		generation_bits = 0;
+		RNG_HARVEST(taps, generation_bits);
+
+		/* append to the output word, spilling into the next one when it fills up */
+		if(count < space) {
+			random_result_int = (random_result_int << count) | generation_bits;
+			space -= count;
+		}
+		else {
+			*(buf + i++) = (space < 64 ? random_result_int << space : 0) | (generation_bits >> (count - space));
+			random_result_int = generation_bits;
+			space = 64 - (count - space);
+		}
+
+	}
+
+	RNG_SAVE(state);
+	CA_STATS_END(CA_PHASE_RNG, stats_start, (64*n + count - 1)/count, (64*n + count - 1)/count*count);
+	CA_STATS_BATCH(n);
+
+}
+
+/* bulk call - fill buf with the next n doubles of the stream, the same numbers that n	*/
+/* calls to rule30_rng_next() would return						*/
+static inline void rule30_rng_fill_double(struct rule30_rng_state *state, double *buf, size_t n) {
+
+	register unsigned long int rule = RULE30;	/* the rule to enforce */
+	RNG_REGISTERS;
+	register unsigned long long int random_result_int;
+	size_t i;
+	int j;
+
+	RNG_RESTORE(state);
+	CA_STATS_START(stats_start);
+
+	for(i = 0; i < n; i++) {
+
+		random_result_int = 0;
+		for(j = 0; j < DELTA_MANTISSA; j++) {
+			RNG_GENERATION(rule);
+			random_result_int = (random_result_int << RHS_ONE) | RNG_CENTER_BIT;
+		}
+		*(buf + i) = RNG_MANTISSA_DOUBLE(random_result_int);
+
+	}
+
+	RNG_SAVE(state);
+	CA_STATS_END(CA_PHASE_RNG, stats_start, DELTA_MANTISSA*n, DELTA_MANTISSA*n);
+	CA_STATS_BATCH(n);
+
+}
+
+/* the original single stream interface: a non-zero seed (re)starts the stream and zero */
+/* continues it.  The stream lives in static memory, so this one is not reentrant.	*/
+static inline double rule30_rng(unsigned long int seed) {
+
+	static struct rule30_rng_state state;
+
+	/* start with initial config */
+	if(seed) {
+		rule30_rng_init(&state, seed);
+	}
+#ifdef DEBUG
+	else {
+		/* set up the canonical state for debugging */
+		rule30_rng_init(&state, 0);
+		state.reg[RNG_REGS / 2] = CENTER_MASK;
+	}
+#endif /* DEBUG */
+
+	return(rule30_rng_next(&state));
+
+}
+
+#if defined(__x86_64__) && (RNG_REGS <= 8)
+/* hand vectorized bulk calls for AVX-512, the whole lattice in one vector: the registers	*/
+/* on either side come from a lane permute and the rule is a single ternary logic op, whose	*/
+/* truth table is the rule number.  The center cells of every lane are shifted into acc, of	*/
+/* which only the center register's lane is kept.					*/
+#define RNG_AVX512_REGISTERS	__m512i lattice, left, right, acc, prev_index, next_index;		\
+				long long int prev_lane[8], next_lane[8];				\
+				int lane
+#define RNG_AVX512_RESTORE(state)	for(lane = 0; lane < 8; lane++) {					\
+						prev_lane[lane] = (lane < RNG_REGS) ? (lane + RNG_REGS - 1) % RNG_REGS : lane;	\
+						next_lane[lane] = (lane < RNG_REGS) ? (lane + 1) % RNG_REGS : lane;	\
+					}								\
+					prev_index = _mm512_loadu_si512(prev_lane);			\
+					next_index = _mm512_loadu_si512(next_lane);			\
+					lattice = _mm512_maskz_loadu_epi64((1 << RNG_REGS) - 1, (state)->reg)
+#define RNG_AVX512_SAVE(state)		_mm512_mask_storeu_epi64((state)->reg, (1 << RNG_REGS) - 1, lattice)
+#define RNG_AVX512_GENERATION	left = _mm512_or_si512(_mm512_srli_epi64(lattice, 1), _mm512_slli_epi64(_mm512_permutexvar_epi64(prev_index, lattice), WORDSIZE - 1));	\
+				right = _mm512_or_si512(_mm512_slli_epi64(lattice, 1), _mm512_srli_epi64(_mm512_permutexvar_epi64(next_index, lattice), WORDSIZE - 1));	\
+				lattice = _mm512_ternarylogic_epi64(left, lattice, right, RULE30);	\
+				acc = _mm512_ternarylogic_epi64(_mm512_slli_epi64(acc, 1), _mm512_srli_epi64(lattice, DELTA_CENTER), _mm512_set1_epi64(RHS_ONE), 0xF8)	/* a | (b & c) */
+#define RNG_AVX512_CENTER	((unsigned long long int)_mm_cvtsi128_si64(_mm512_castsi512_si128(_mm512_permutexvar_epi64(_mm512_set1_epi64(RNG_REGS / 2), acc))))
+
+static inline CA_TARGET_AVX512 void rule30_rng_fill_u64_avx512(struct rule30_rng_state *state, uint64_t *buf, size_t n) {
+
+	RNG_AVX512_REGISTERS;
+	size_t i;
+	int j;
+
+	RNG_AVX512_RESTORE(state);
+	CA_STATS_START(stats_start);
+
+	for(i = 0; i < n; i++) {
+
+		acc = _mm512_setzero_si512();
+		for(j = 0; j < 64; j++) {
+			RNG_AVX512_GENERATION;
+		}
+		*(buf + i) = RNG_AVX512_CENTER;
+
+	}
+
+	RNG_AVX512_SAVE(state);
+	CA_STATS_END(CA_PHASE_RNG, stats_start, 64*n, 64*n);
+	CA_STATS_BATCH(n);
+
+}
+
+static inline CA_TARGET_AVX512 void rule30_rng_fill_double_avx512(struct rule30_rng_state *state, double *buf, size_t n) {
+
+	RNG_AVX512_REGISTERS;
+	size_t i;
+	int j;
+
+	RNG_AVX512_RESTORE(state);
+	CA_STATS_START(stats_start);
+
+	for(i = 0; i < n; i++) {
+
+		acc = _mm512_setzero_si512();
+		for(j = 0; j < DELTA_MANTISSA; j++) {
+			RNG_AVX512_GENERATION;
+		}
+		*(buf + i) = RNG_MANTISSA_DOUBLE(RNG_AVX512_CENTER);
+
+	}
+
+	RNG_AVX512_SAVE(state);
+	CA_STATS_END(CA_PHASE_RNG, stats_start, DELTA_MANTISSA*n, DELTA_MANTISSA*n);
+	CA_STATS_BATCH(n);
+
+}
+
+/* the same for AVX2, the lattice in two vectors of four registers.  Only the low bit of	*/
+/* the register on the left and the high bit of the one on the right are needed, so one	*/
+/* permute of 32-bit lanes from each vector and an immediate blend, both worked out from	*/
+/* RNG_REGS, gather the low half of the left register and the high half of the right one	*/
+/* into edge.  The bit shifted in from the left is disjoint from lattice >> 1, so rule 30	*/
+/* left ^ (center | right) can take it last, off the path through the right edge.  The	*/
+/* center cells are shifted into acc from the vector holding the center register.	*/
+#define RNG_AVX2_PREV(cell)	(((cell) < RNG_REGS) ? ((cell) + RNG_REGS - 1) % RNG_REGS : (cell))
+#define RNG_AVX2_NEXT(cell)	(((cell) < RNG_REGS) ? ((cell) + 1) % RNG_REGS : (cell))
+#define RNG_AVX2_EDGE_INDEX(half)	_mm256_setr_epi32(2*(RNG_AVX2_PREV(4*(half)) % 4), 2*(RNG_AVX2_NEXT(4*(half)) % 4) + 1,		\
+					2*(RNG_AVX2_PREV(4*(half) + 1) % 4), 2*(RNG_AVX2_NEXT(4*(half) + 1) % 4) + 1,			\
+					2*(RNG_AVX2_PREV(4*(half) + 2) % 4), 2*(RNG_AVX2_NEXT(4*(half) + 2) % 4) + 1,			\
+					2*(RNG_AVX2_PREV(4*(half) + 3) % 4), 2*(RNG_AVX2_NEXT(4*(half) + 3) % 4) + 1)
+#define RNG_AVX2_EDGE_HIGH(half)	(((RNG_AVX2_PREV(4*(half)) >= 4) ? 0x01 : 0) | ((RNG_AVX2_NEXT(4*(half)) >= 4) ? 0x02 : 0) |		\
+					((RNG_AVX2_PREV(4*(half) + 1) >= 4) ? 0x04 : 0) | ((RNG_AVX2_NEXT(4*(half) + 1) >= 4) ? 0x08 : 0) |	\
+					((RNG_AVX2_PREV(4*(half) + 2) >= 4) ? 0x10 : 0) | ((RNG_AVX2_NEXT(4*(half) + 2) >= 4) ? 0x20 : 0) |	\
+					((RNG_AVX2_PREV(4*(half) + 3) >= 4) ? 0x40 : 0) | ((RNG_AVX2_NEXT(4*(half) + 3) >= 4) ? 0x80 : 0))
+#define RNG_AVX2_MASK(half)	_mm256_set_epi64x(-(RNG_REGS > 4*(half) + 3), -(RNG_REGS > 4*(half) + 2), -(RNG_REGS > 4*(half) + 1), -(RNG_REGS > 4*(half)))
+#define RNG_AVX2_REGISTERS	__m256i lattice[2], edge[2], acc, edge_index[2]
+#define RNG_AVX2_RESTORE(state)	edge_index[0] = RNG_AVX2_EDGE_INDEX(0);								\
+				edge_index[1] = RNG_AVX2_EDGE_INDEX(1);								\
+				lattice[0] = _mm256_maskload_epi64((const long long int *)(state)->reg, RNG_AVX2_MASK(0));	\
+				lattice[1] = _mm256_maskload_epi64((const long long int *)(state)->reg + 4, RNG_AVX2_MASK(1))
+#define RNG_AVX2_SAVE(state)	_mm256_maskstore_epi64((long long int *)(state)->reg, RNG_AVX2_MASK(0), lattice[0]);		\
+				_mm256_maskstore_epi64((long long int *)(state)->reg + 4, RNG_AVX2_MASK(1), lattice[1])
+#define RNG_AVX2_EDGE(half)	edge[half] = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(lattice[0], edge_index[half]),	\
+					_mm256_permutevar8x32_epi32(lattice[1], edge_index[half]), RNG_AVX2_EDGE_HIGH(half))
+#define RNG_AVX2_HALF(half)	lattice[half] = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(lattice[half], 1),		\
+					_mm256_or_si256(_mm256_or_si256(lattice[half], _mm256_slli_epi64(lattice[half], 1)), _mm256_srli_epi64(edge[half], WORDSIZE - 1))),	\
+					_mm256_slli_epi64(edge[half], WORDSIZE - 1))
+#define RNG_AVX2_GENERATION	RNG_AVX2_EDGE(0);										\
+				RNG_AVX2_EDGE(1);										\
+				RNG_AVX2_HALF(0);										\
+				RNG_AVX2_HALF(1);										\
+				acc = _mm256_or_si256(_mm256_slli_epi64(acc, 1), _mm256_and_si256(_mm256_srli_epi64(lattice[RNG_REGS / 2 / 4], DELTA_CENTER), _mm256_set1_epi64x(RHS_ONE)))
+#define RNG_AVX2_CENTER		((unsigned long long int)_mm256_extract_epi64(acc, RNG_REGS / 2 % 4))
+
+static inline CA_TARGET_AVX2 void rule30_rng_fill_u64_avx2(struct rule30_rng_state *state, uint64_t *buf, size_t n) {
+
+	RNG_AVX2_REGISTERS;
+	size_t i;
+	int j;
+
+	RNG_AVX2_RESTORE(state);
+	CA_STATS_START(stats_start);
+
+	for(i = 0; i < n; i++) {
+
+		acc = _mm256_setzero_si256();
+		for(j = 0; j < 64; j++) {
+			RNG_AVX2_GENERATION;
+		}
+		*(buf + i) = RNG_AVX2_CENTER;
+
+	}
+
+	RNG_AVX2_SAVE(state);
+	CA_STATS_END(CA_PHASE_RNG, stats_start, 64*n, 64*n);
+	CA_STATS_BATCH(n);
+
+}
+
+static inline CA_TARGET_AVX2 void rule30_rng_fill_double_avx2(struct rule30_rng_state *state, double *buf, size_t n) {
+
+	RNG_AVX2_REGISTERS;
+	size_t i;
+	int j;
+
+	RNG_AVX2_RESTORE(state);
+	CA_STATS_START(stats_start);
+
+	for(i = 0; i < n; i++) {
+
+		acc = _mm256_setzero_si256();
+		for(j = 0; j < DELTA_MANTISSA; j++) {
+			RNG_AVX2_GENERATION;
+		}
+		*(buf + i) = RNG_MANTISSA_DOUBLE(RNG_AVX2_CENTER);
+
+	}
+
+	RNG_AVX2_SAVE(state);
+	CA_STATS_END(CA_PHASE_RNG, stats_start, DELTA_MANTISSA*n, DELTA_MANTISSA*n);
+	CA_STATS_BATCH(n);
+
+}
+#else
+#define rule30_rng_fill_u64_avx512	rule30_rng_fill_u64
+#define rule30_rng_fill_double_avx512	rule30_rng_fill_double
+#define rule30_rng_fill_u64_avx2	rule30_rng_fill_u64
+#define rule30_rng_fill_double_avx2	rule30_rng_fill_double
+#endif /* __x86_64__ */
+
+/* the bulk calls compiled for each instruction set, the best one for the CPU chosen at	*/
+/* startup - see ca.dispatch.h							*/
+CA_DISPATCH_VARIANTS(rule30_rng_fill_u64_dispatch, rule30_rng_fill_u64, rule30_rng_fill_u64, rule30_rng_fill_u64_avx2, rule30_rng_fill_u64_avx512,
+		     (struct rule30_rng_state *state, uint64_t *buf, size_t n), (state, buf, n))
+CA_DISPATCH_DEFINE(rule30_rng_fill_u64_taps_dispatch, rule30_rng_fill_u64_taps,
+		   (struct rule30_rng_state *state, const struct rule30_taps *taps, uint64_t *buf, size_t n), (state, taps, buf, n))
+CA_DISPATCH_VARIANTS(rule30_rng_fill_double_dispatch, rule30_rng_fill_double, rule30_rng_fill_double, rule30_rng_fill_double_avx2, rule30_rng_fill_double_avx512,
+		     (struct rule30_rng_state *state, double *buf, size_t n), (state, buf, n))
+
+#endif /* RULE30_RNG_H */
@@ -0,0 +1,394 @@
+/************************************************************************/
+/* Shared-memory random number service					*/
+/*									*/
+/* Lets the processes of one host share a single generator instead of	*/
+/* each holding and warming up a lattice of its own: the daemon		*/
+/* rule30shmd keeps a POSIX shared-memory object of SHM_RINGS rings,	*/
+/* each of SHM_DEPTH blocks of SHM_BLOCK 64-bit words, and fills them	*/
+/* ahead of the clients.  A client claims a free ring for a substream	*/
+/* of its choosing (an MPI rank, say) and then takes blocks from it	*/
+/* exactly as from rule30.pool.h - one producer and one consumer per	*/
+/* ring, head and tail advanced with release/acquire ordering - so the	*/
+/* fast path makes no system calls at all.				*/
+/*									*/
+/* The blocks are the counter-based generator of rule30.ctr.h, keyed by	*/
+/* the daemon's seed: substream s is the output words from s <<		*/
+/* SHM_SUBSTREAM_SHIFT on (s below 2^24; a larger s would wrap onto s	*/
+/* mod 2^24, and is refused), so a client sees the same numbers		*/
+/* whichever ring it is given and whenever it attaches, and can		*/
+/* reproduce them without the daemon by calling rule30_ctr_fill_u64()	*/
+/* with the key in the header.						*/
+/*									*/
+/*	rule30_shm_attach()		claim a ring for a substream	*/
+/*	rule30_shm_acquire()		next full block, waiting	*/
+/*	rule30_shm_try_acquire()	next full block, or NULL	*/
+/*	rule30_shm_release()		give the block back		*/
+/*	rule30_shm_fill_u64()		copy n words out of the blocks	*/
+/*	rule30_shm_detach()		free the ring and unmap		*/
+/*									*/
+/* and for the daemon, rule30shmd:					*/
+/*									*/
+/*	rule30_shm_init()		set up a new object		*/
+/*	rule30_shm_serve()		one pass over a worker's rings	*/
+/*									*/
+/* A ring goes FREE -> TAKEN -> CLAIMED as the client writes its pid	*/
+/* and substream, READY once the daemon has rewound it to the start of	*/
+/* the substream, and back to FREE on detach, or when the daemon finds	*/
+/* the owner has exited at any of these steps (a ring left TAKEN with	*/
+/* no pid written is given up after SHM_TAKEN_TIMEOUT).  A client	*/
+/* waiting on a daemon that has been killed gives up as on one that has	*/
+/* stopped.  Link with -pthread (and -lrt on older C libraries).	*/
+/************************************************************************/
+
+#ifndef RULE30_SHM_H
+#define RULE30_SHM_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rule30.ctr.h"
+
+#define SHM_NAME		"/rule30"	/* default shared-memory object */
+#define SHM_MAGIC		"R30SHM\0\0"
+#define SHM_VERSION		3
+#ifndef SHM_BLOCK
+#define SHM_BLOCK		512		/* 64-bit words per block, 4 kB */
+#endif
+#ifndef SHM_DEPTH
+#define SHM_DEPTH		8		/* blocks per ring, a power of two */
+#endif
+#define SHM_RINGS		64		/* default rings - clients at once */
+#define SHM_SUBSTREAM_SHIFT	40		/* 2^40 words per substream, 2^24 substreams */
+#define SHM_LINE		64		/* cache line */
+#define SHM_TAKEN_TIMEOUT	1000000000ULL	/* nanoseconds a ring may stay TAKEN without an owner */
+#define SHM_DAEMON_CHECK	1024		/* yields of a waiting client between checks on the daemon */
+
+/* ring states */
+#define SHM_FREE		0
+#define SHM_TAKEN		1		/* a client is writing its claim */
+#define SHM_CLAIMED		2		/* waiting for the daemon to rewind */
+#define SHM_READY		3
+
+/* one ring, with the claim of its client */
+struct rule30_shm_ring {
+
+	_Atomic uint64_t head __attribute__((aligned(SHM_LINE)));	/* blocks filled - written by the daemon */
+	_Atomic uint64_t tail __attribute__((aligned(SHM_LINE)));	/* blocks consumed - written by the client */
+	_Atomic uint32_t status __attribute__((aligned(SHM_LINE)));
+	_Atomic int32_t owner;						/* pid of the client, 0 until it is written */
+	uint64_t substream;
+	uint64_t position;						/* next word to fill - the daemon's */
+	uint64_t taken;							/* when seen TAKEN without an owner, or 0 - the daemon's */
+	uint64_t block[SHM_DEPTH][SHM_BLOCK] __attribute__((aligned(SHM_LINE)));
+
+};
+
+/* the shared-memory object - the magic is written last, once the rings are set up */
+struct rule30_shm {
+
+	char magic[8];
+	uint32_t version;
+	uint32_t rings;
+	uint32_t block;
+	uint32_t depth;
+	uint64_t seed;
+	struct rule30_ctr_key key;
+	_Atomic int running;
+	int32_t daemon;			/* pid of the daemon serving it */
+	struct rule30_shm_ring ring[] __attribute__((aligned(SHM_LINE)));
+
+};
+
+/* a client's view of its ring */
+struct rule30_shm_client {
+
+	struct rule30_shm *shm;
+	size_t size;
+	struct rule30_shm_ring *ring;
+	const uint64_t *block;		/* the block being read by rule30_shm_fill_u64() */
+	size_t used;			/* words of it already read */
+
+};
+
+/* bytes of the object for a number of rings */
+static inline size_t rule30_shm_size(uint32_t rings) {
+
+	return(sizeof(struct rule30_shm) + rings*sizeof(struct rule30_shm_ring));
+
+}
+
+/* the process has exited - a process of another user is alive, if not ours to signal */
+static inline int rule30_shm_exited(pid_t pid) {
+
+	return((kill(pid, 0) < 0) && (errno == ESRCH));
+
+}
+
+/* the daemon still serves the object - a daemon that was killed leaves running set */
+static inline int rule30_shm_serving(struct rule30_shm *shm) {
+
+	return(atomic_load_explicit(&shm->running, memory_order_relaxed) && !rule30_shm_exited(shm->daemon));
+
+}
+
+/* monotonic nanoseconds */
+static inline uint64_t rule30_shm_now(void) {
+
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return((uint64_t)now.tv_sec*1000000000ULL + now.tv_nsec);
+
+}
+
+/* set up a new object of rings rings for the daemon with pid daemon - the magic is	*/
+/* written last, so a client never maps a half set up object				*/
+static inline void rule30_shm_init(struct rule30_shm *shm, uint32_t rings, unsigned long int seed, pid_t daemon) {
+
+	uint32_t i;
+
+	shm->version = SHM_VERSION;
+	shm->rings = rings;
+	shm->block = SHM_BLOCK;
+	shm->depth = SHM_DEPTH;
+	shm->seed = seed;
+	shm->daemon = daemon;
+	rule30_ctr_init(&shm->key, seed);
+	atomic_init(&shm->running, 1);
+	for(i = 0; i < rings; i++) {
+		atomic_init(&shm->ring[i].head, 0);
+		atomic_init(&shm->ring[i].tail, 0);
+		atomic_init(&shm->ring[i].status, SHM_FREE);
+		atomic_init(&shm->ring[i].owner, 0);
+		shm->ring[i].taken = 0;
+	}
+	atomic_thread_fence(memory_order_release);
+	memcpy(shm->magic, SHM_MAGIC, sizeof(shm->magic));
+
+}
+
+/* one pass of a daemon worker over rings first, first + stride, ... - rewind new claims,	*/
+/* refill every free block and, if reap is set, free the rings of exited clients -	*/
+/* returns 0 if there was nothing to do							*/
+static inline int rule30_shm_serve(struct rule30_shm *shm, uint32_t first, uint32_t stride, int reap) {
+
+	struct rule30_shm_ring *ring;
+	uint64_t head;
+	uint32_t i, status;
+	pid_t owner;
+	int busy = 0;
+
+	for(i = first; i < shm->rings; i += stride) {
+
+		ring = &shm->ring[i];
+		status = atomic_load_explicit(&ring->status, memory_order_acquire);
+
+		/* a client that died holding the ring, at whatever step of its claim - a TAKEN ring has	*/
+		/* no owner for the moment before the client writes it, so a ring that stays TAKEN		*/
+		/* without one for SHM_TAKEN_TIMEOUT is taken to be left by a client that died there.		*/
+		/* Only the daemon moves a ring on from a dead owner, so the claim cannot change hands.		*/
+		if(reap && (status != SHM_FREE)) {
+			owner = atomic_load_explicit(&ring->owner, memory_order_relaxed);
+			if(owner || (status != SHM_TAKEN))
+				ring->taken = 0;
+			else if(!ring->taken)
+				ring->taken = rule30_shm_now();
+			if((owner && rule30_shm_exited(owner)) || (ring->taken && (rule30_shm_now() - ring->taken > SHM_TAKEN_TIMEOUT))) {
+				ring->taken = 0;
+				atomic_store_explicit(&ring->owner, 0, memory_order_relaxed);
+				atomic_compare_exchange_strong(&ring->status, &status, SHM_FREE);
+				continue;
+			}
+		}
+
+		/* a new claim - rewind to the start of its substream */
+		if(status == SHM_CLAIMED) {
+			atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+			atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+			ring->position = ring->substream << SHM_SUBSTREAM_SHIFT;
+			atomic_store_explicit(&ring->status, SHM_READY, memory_order_release);
+			status = SHM_READY;
+		}
+		if(status != SHM_READY)
+			continue;
+
+		/* refill every free block */
+		head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+		while(head - atomic_load_explicit(&ring->tail, memory_order_acquire) < SHM_DEPTH) {
+			rule30_ctr_fill_u64(&shm->key, ring->position, ring->block[head % SHM_DEPTH], SHM_BLOCK);
+			ring->position += SHM_BLOCK;
+			atomic_store_explicit(&ring->head, ++head, memory_order_release);
+			busy = 1;
+		}
+
+	}
+
+	return(busy);
+
+}
+
+/* map the service's object and claim a free ring for the substream, waiting for the	*/
+/* daemon to rewind it - returns -1 if there is no service, no free ring or the		*/
+/* substream is out of range								*/
+static inline int rule30_shm_attach(struct rule30_shm_client *client, const char *name, uint64_t substream) {
+
+	struct rule30_shm *shm;
+	struct stat st;
+	uint32_t i, status;
+	int fd, spins;
+
+	if(substream >> (64 - SHM_SUBSTREAM_SHIFT))
+		return(-1);
+
+	fd = shm_open(name ? name : SHM_NAME, O_RDWR, 0);
+	if(fd < 0)
+		return(-1);
+	if(fstat(fd, &st) || (st.st_size < (off_t)sizeof(struct rule30_shm))) {
+		close(fd);
+		return(-1);
+	}
+	shm = (struct rule30_shm *)mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(shm == MAP_FAILED)
+		return(-1);
+
+	if(memcmp(shm->magic, SHM_MAGIC, sizeof(shm->magic)) || (shm->version != SHM_VERSION) ||
+	   (shm->block != SHM_BLOCK) || (shm->depth != SHM_DEPTH) || ((size_t)st.st_size < rule30_shm_size(shm->rings)) ||
+	   !rule30_shm_serving(shm)) {
+		munmap(shm, st.st_size);
+		return(-1);
+	}
+
+	client->shm = shm;
+	client->size = st.st_size;
+	client->block = NULL;
+	client->used = SHM_BLOCK;
+
+	for(i = 0; i < shm->rings; i++) {
+
+		status = SHM_FREE;
+		if(!atomic_compare_exchange_strong(&shm->ring[i].status, &status, SHM_TAKEN))
+			continue;
+
+		/* a ring the daemon gave up on while the claim was being written is left to its new client */
+		client->ring = &shm->ring[i];
+		atomic_store_explicit(&client->ring->owner, getpid(), memory_order_relaxed);
+		client->ring->substream = substream;
+		status = SHM_TAKEN;
+		if(!atomic_compare_exchange_strong(&client->ring->status, &status, SHM_CLAIMED))
+			continue;
+
+		for(spins = 1; atomic_load_explicit(&client->ring->status, memory_order_acquire) != SHM_READY; spins++) {
+			if(!atomic_load_explicit(&shm->running, memory_order_relaxed) || (!(spins % SHM_DAEMON_CHECK) && !rule30_shm_serving(shm))) {
+				atomic_store_explicit(&client->ring->owner, 0, memory_order_relaxed);
+				atomic_store_explicit(&client->ring->status, SHM_FREE, memory_order_release);
+				break;
+			}
+			sched_yield();
+		}
+		if(atomic_load_explicit(&client->ring->status, memory_order_relaxed) == SHM_READY)
+			return(0);
+		break;
+
+	}
+
+	munmap(shm, st.st_size);
+	client->shm = NULL;
+	return(-1);
+
+}
+
+/* the next full block, or NULL if the daemon has not filled one yet */
+static inline const uint64_t *rule30_shm_try_acquire(struct rule30_shm_client *client) {
+
+	struct rule30_shm_ring *ring = client->ring;
+	uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+	if(atomic_load_explicit(&ring->head, memory_order_acquire) == tail)
+		return(NULL);
+
+	return(ring->block[tail % SHM_DEPTH]);
+
+}
+
+/* the next full block, waiting for the daemon if the ring is empty - NULL if the daemon has stopped	*/
+/* or died												*/
+static inline const uint64_t *rule30_shm_acquire(struct rule30_shm_client *client) {
+
+	const uint64_t *block;
+	int spins = 0;
+
+	while(!(block = rule30_shm_try_acquire(client))) {
+		if(!atomic_load_explicit(&client->shm->running, memory_order_relaxed) ||
+		   (!(++spins % SHM_DAEMON_CHECK) && !rule30_shm_serving(client->shm)))
+			return(NULL);
+		sched_yield();
+	}
+
+	return(block);
+
+}
+
+/* done with the block from the last acquire - the daemon may refill it */
+static inline void rule30_shm_release(struct rule30_shm_client *client) {
+
+	struct rule30_shm_ring *ring = client->ring;
+
+	atomic_store_explicit(&ring->tail, atomic_load_explicit(&ring->tail, memory_order_relaxed) + 1, memory_order_release);
+
+}
+
+/* copy the next n words of the substream into buf - not to be mixed with acquire/release,	*/
+/* returns the number of words copied, short only if the daemon has stopped			*/
+static inline size_t rule30_shm_fill_u64(struct rule30_shm_client *client, uint64_t *buf, size_t n) {
+
+	size_t count, done = 0;
+
+	while(done < n) {
+
+		if(client->used == SHM_BLOCK) {
+			if(client->block)
+				rule30_shm_release(client);
+			client->used = 0;
+			if(!(client->block = rule30_shm_acquire(client))) {
+				client->used = SHM_BLOCK;
+				break;
+			}
+		}
+
+		count = SHM_BLOCK - client->used;
+		if(count > n - done)
+			count = n - done;
+		memcpy(buf + done, client->block + client->used, count*sizeof(uint64_t));
+
+		client->used += count;
+		done += count;
+
+	}
+
+	return(done);
+
+}
+
+/* give the ring back and unmap the object */
+static inline void rule30_shm_detach(struct rule30_shm_client *client) {
+
+	if(!client->shm)
+		return;
+
+	atomic_store_explicit(&client->ring->owner, 0, memory_order_relaxed);
+	atomic_store_explicit(&client->ring->status, SHM_FREE, memory_order_release);
+	munmap(client->shm, client->size);
+	client->shm = NULL;
+	client->ring = NULL;
+
+}
+
+#endif /* RULE30_SHM_H */
@@ -0,0 +1,218 @@
+/************************************************************************/
+/* The rule 30 shared-memory random number service			*/
+/*									*/
+/* Creates the shared-memory object of rule30.shm.h and keeps its rings	*/
+/* full until it is stopped with SIGINT or SIGTERM, when it marks the	*/
+/* service stopped (so waiting clients return) and unlinks the object.	*/
+/* Each of the worker threads serves every j-th ring: it rewinds newly	*/
+/* claimed rings to the start of their substream, refills any ring with	*/
+/* a free block, and frees the rings of clients that have exited	*/
+/* without detaching.  When a pass over its rings finds nothing to do a	*/
+/* worker sleeps briefly, so an idle service costs next to nothing.	*/
+/*									*/
+/* The object is created private to the user (mode 0600); -m opens it	*/
+/* to a group, e.g. -m 0660 for the ranks of a job run by several	*/
+/* users.  A name that is already taken is refused unless the object	*/
+/* is one of ours whose daemon has died, which is replaced.		*/
+/*									*/
+/*	rule30shmd [-n name] [-s seed] [-k rings] [-j threads]		*/
+/*		   [-m mode]						*/
+/*									*/
+/* compile with:							*/
+/*	gcc -O3 -o rule30shmd rule30.shmd.c -pthread -lrt		*/
+/************************************************************************/
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+
+#include "rule30.shm.h"
+
+#define IDLE_SLEEP	50000		/* nanoseconds a worker sleeps after an idle pass */
+#define OWNER_CHECK	1000		/* idle passes between checks for exited clients */
+
+struct worker {
+
+	struct rule30_shm *shm;
+	uint32_t first;
+	uint32_t stride;
+
+};
+
+/* a worker - keep its rings rewound and full */
+void *produce(void *arg) {
+
+	struct worker *worker = (struct worker *)arg;
+	struct rule30_shm *shm = worker->shm;
+	struct timespec idle = { 0, IDLE_SLEEP };
+	int passes = 0;
+
+	while(atomic_load_explicit(&shm->running, memory_order_relaxed)) {
+
+		if(!rule30_shm_serve(shm, worker->first, worker->stride, passes == OWNER_CHECK))
+			nanosleep(&idle, NULL);
+		if(passes++ == OWNER_CHECK)
+			passes = 0;
+
+	}
+
+	return(NULL);
+
+}
+
+/* the pid of the daemon serving an existing object, 0 if it is not a service object	*/
+/* (or is still being set up) and -1 if it cannot be read					*/
+pid_t serving(const char *name) {
+
+	struct rule30_shm *shm;
+	struct stat st;
+	pid_t pid = 0;
+	int fd;
+
+	fd = shm_open(name, O_RDONLY, 0);
+	if(fd < 0)
+		return(-1);
+	if(fstat(fd, &st)) {
+		close(fd);
+		return(-1);
+	}
+	if(st.st_size < (off_t)sizeof(struct rule30_shm)) {
+		close(fd);
+		return(0);
+	}
+	shm = (struct rule30_shm *)mmap(NULL, sizeof(struct rule30_shm), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(shm == MAP_FAILED)
+		return(-1);
+
+	if(!memcmp(shm->magic, SHM_MAGIC, sizeof(shm->magic)) && (shm->version == SHM_VERSION))
+		pid = shm->daemon;
+	munmap(shm, sizeof(struct rule30_shm));
+	return(pid);
+
+}
+
+void usage(char *progname) {
+
+	fprintf(stderr, "usage: %s [-n name] [-s seed] [-k rings] [-j threads] [-m mode]\n", progname);
+	exit(1);
+
+}
+
+int main(int argc, char **argv) {
+
+	int c, fd, sig, threads = 1;
+	mode_t mode = 0600;
+	pid_t pid;
+	uint32_t rings = SHM_RINGS;
+	unsigned long int seed = 1234523;
+	char *name = SHM_NAME;
+	size_t size;
+	struct rule30_shm *shm;
+	struct worker *worker;
+	pthread_t *thread;
+	sigset_t signals;
+
+	while((c = getopt(argc, argv, "n:s:k:j:m:")) != -1) {
+		switch(c) {
+			case 'n':
+				name = optarg;
+				break;
+			case 's':
+				seed = strtoul(optarg, NULL, 0);
+				break;
+			case 'k':
+				rings = strtoul(optarg, NULL, 0);
+				break;
+			case 'j':
+				threads = atoi(optarg);
+				break;
+			case 'm':
+				mode = strtoul(optarg, NULL, 8) & 0777;
+				break;
+			default:
+				usage((char *)argv[0]);
+		}
+	}
+	if((rings < 1) || (threads < 1) || (optind != argc)) usage((char *)argv[0]);
+	if((uint32_t)threads > rings)
+		threads = rings;
+
+	/* a fresh object - one left by a killed daemon, with stale claims, is replaced but one	*/
+	/* that is still served, or isn't ours, is left alone						*/
+	size = rule30_shm_size(rings);
+	umask(0);		/* exactly the mode asked for */
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, mode);
+	if((fd < 0) && (errno == EEXIST)) {
+		pid = serving(name);
+		if((pid > 0) && (kill(pid, 0) < 0) && (errno == ESRCH)) {
+			fprintf(stderr, "%s: replacing %s, left by daemon %d\n", argv[0], name, (int)pid);
+			shm_unlink(name);
+			fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, mode);
+		}
+		else {
+			if(pid > 0)
+				fprintf(stderr, "%s is already served by daemon %d\n", name, (int)pid);
+			else
+				fprintf(stderr, "%s exists and is not a rule 30 service - remove it if it is stale\n", name);
+			exit(1);
+		}
+	}
+	if(fd < 0) {
+		fprintf(stderr, "couldn't create shared memory %s: %s\n", name, strerror(errno));
+		exit(1);
+	}
+	if(ftruncate(fd, size)) {
+		fprintf(stderr, "couldn't size shared memory %s: %s\n", name, strerror(errno));
+		shm_unlink(name);
+		exit(1);
+	}
+	shm = (struct rule30_shm *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(shm == MAP_FAILED) {
+		fprintf(stderr, "couldn't map shared memory %s: %s\n", name, strerror(errno));
+		shm_unlink(name);
+		exit(1);
+	}
+
+	rule30_shm_init(shm, rings, seed, getpid());
+
+	/* the signals are taken by sigwait() below, not by the workers */
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+	worker = (struct worker *)calloc(threads, sizeof(struct worker));
+	thread = (pthread_t *)calloc(threads, sizeof(pthread_t));
+	if(!worker || !thread) {
+		fprintf(stderr, "couldn't allocate working memory\n");
+		shm_unlink(name);
+		exit(1);
+	}
+	for(c = 0; c < threads; c++) {
+		worker[c].shm = shm;
+		worker[c].first = c;
+		worker[c].stride = threads;
+		if(pthread_create(&thread[c], NULL, produce, &worker[c])) {
+			fprintf(stderr, "couldn't start thread %d\n", c);
+			shm_unlink(name);
+			exit(1);
+		}
+	}
+
+	fprintf(stderr, "%s: serving %u rings on %s, seed %lu\n", argv[0], rings, name, seed);
+	sigwait(&signals, &sig);
+
+	atomic_store_explicit(&shm->running, 0, memory_order_relaxed);
+	for(c = 0; c < threads; c++)
+		pthread_join(thread[c], NULL);
+	shm_unlink(name);
+	munmap(shm, size);
+
+	free(worker);
+	free(thread);
+	exit(0);
+
+}
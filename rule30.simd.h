@@ -0,0 +1,107 @@
+/************************************************************************/
+/* Multi-stream rule 30 generator for SIMD units			*/
+/*									*/
+/* The 64-bit register array of rule30.rng.h is stepped here for	*/
+/* several independently seeded lattices at once, one lattice per	*/
+/* vector lane: in_reg1 holds register 1 of every lattice, in_reg2	*/
+/* register 2 and so on (structure of arrays).  The word-parallel rule	*/
+/* and the neighbour shifts are plain bitwise operations, so every lane	*/
+/* runs exactly the scalar algorithm and lane k reproduces the scalar	*/
+/* stream seeded with seeds[k].  Outputs are interleaved into one	*/
+/* buffer, word i of lane k landing at buf[i * RNG_LANES + k].  A call	*/
+/* always steps whole groups of RNG_LANES words, so when n is not a	*/
+/* multiple of RNG_LANES the surplus words of the last group are	*/
+/* dropped and the next call starts on a fresh group.			*/
+/*									*/
+/* The lane count follows the instruction set the code is compiled for:	*/
+/*									*/
+/*	-mavx512f		8 lanes of 512 bits			*/
+/*	-mavx2			4 lanes of 256 bits			*/
+/*	otherwise		2 lanes of 128 bits (SSE2/NEON)		*/
+/*									*/
+/* The lane count fixes the layout of the state and of the output, so	*/
+/* it is not picked at run time like the kernels of ca.dispatch.h.	*/
+/* RULE30_SIMD_DEFINE(name, lanes, target) defines the generator for	*/
+/* any lane count with its functions compiled for one of the targets of	*/
+/* ca.dispatch.h, which is how "rule30.verify.c" checks all three in	*/
+/* one binary.								*/
+/*									*/
+/* compile with e.g.:							*/
+/*	gcc -O3 -march=native ...					*/
+/************************************************************************/
+
+#ifndef RULE30_SIMD_H
+#define RULE30_SIMD_H
+
+#include <string.h>
+
+#include "rule30.rng.h"
+
+#if defined(__AVX512F__)
+#define RNG_LANES	8
+#elif defined(__AVX2__)
+#define RNG_LANES	4
+#else
+#define RNG_LANES	2
+#endif /* __AVX512F__ */
+
+/* the generator at a lane count, with its functions compiled for target */
+#define RULE30_SIMD_DEFINE(name, lanes, target)									\
+														\
+/* one register of every lattice */										\
+typedef unsigned long int name##_vec __attribute__((vector_size((lanes) * sizeof(unsigned long int))));		\
+														\
+/* lanes independent streams, stored as a structure of arrays */						\
+struct name##_state {												\
+														\
+	name##_vec reg[RNG_REGS];		/* the circular register arrays, left to right */		\
+														\
+} __attribute__((aligned(64)));											\
+														\
+CA_LATTICE_DEFINE(name##_lattice, name##_vec, RNG_REGS, WORDSIZE)						\
+														\
+/* seed the streams - lane k is loaded with seeds[k] just as rule30_rng_init() would */				\
+static inline target void name##_init(struct name##_state *state, const unsigned long int *seeds) {		\
+														\
+	int i, k;												\
+														\
+	for(i = 0; i < RNG_REGS; i++)										\
+		for(k = 0; k < (lanes); k++)									\
+			state->reg[i][k] = *(seeds + k);							\
+														\
+}														\
+														\
+/* fill buf with the next n 64-bit words of the streams, interleaved lane by lane */				\
+static inline target void name##_fill_u64(struct name##_state *state, uint64_t *buf, size_t n) {		\
+														\
+	register unsigned long int rule = RULE30;	/* the rule to enforce */				\
+	name##_lattice lattice;											\
+	name##_vec random_result_int;										\
+	size_t i;												\
+	int j;													\
+														\
+	RNG_RESTORE(state);											\
+														\
+	for(i = 0; i < n; i += (lanes)) {									\
+														\
+		random_result_int = (name##_vec){ 0 };								\
+		for(j = 0; j < 64; j++) {									\
+			name##_lattice_step(&lattice, rule);							\
+			random_result_int = (random_result_int << RHS_ONE) | RNG_CENTER_BIT;			\
+		}												\
+														\
+		if(n - i >= (lanes))										\
+			memcpy(buf + i, &random_result_int, sizeof(name##_vec));				\
+		else												\
+			memcpy(buf + i, &random_result_int, (n - i)*sizeof(uint64_t));				\
+														\
+	}													\
+														\
+	RNG_SAVE(state);											\
+														\
+}
+
+/* struct rule30_simd_state, rule30_simd_init() and rule30_simd_fill_u64() for the lane count compiled for */
+RULE30_SIMD_DEFINE(rule30_simd, RNG_LANES, )
+
+#endif /* RULE30_SIMD_H */
@@ -0,0 +1,1611 @@
+/************************************************************************/
+/* Differential verification of the optimized rule 30 kernels		*/
+/*									*/
+/* Every fast path in the tree - the word-parallel lattice of ca.h in	*/
+/* each instruction set variant of ca.dispatch.h, the lattice cut over	*/
+/* threads of ca.domain.h, the bulk RNG calls and their AVX2 and	*/
+/* AVX-512 kernels, tap harvesting, the producer pool, the checkpoint	*/
+/* index, the light-cone tables, the SIMD lanes at each lane count, the	*/
+/* counter mode and the shared-memory service (a daemon worker run from	*/
+/* a thread), the jump-ahead and the XR30256 cipher - is run in		*/
+/* lockstep with a reference: the original per-bit loop of		*/
+/* rule30_rng(), which reads each cell's neighbourhood off the bottom	*/
+/* of the registers and rotates them one cell at a time, kept here	*/
+/* verbatim but for the register count.  The cases are random (seeds,	*/
+/* lattice widths, rules, lengths and the split of a stream into calls)	*/
+/* and reproducible with -s; the first diverging generation of each	*/
+/* failure is reported with the case that produced it.  The conversions	*/
+/* of rule30.dist.h are held against the samplers as published		*/
+/* (Lemire's bounded integers with their divide, the ziggurats a	*/
+/* variate at a time) on words checked above, and the popcount variants	*/
+/* of rule30.battery.h against a count of every bit.  The C++ engine of	*/
+/* ca.engine.hpp is not covered, this being C.				*/
+/*									*/
+/* Known-answer vectors pin the reference itself to the original	*/
+/* programs: the first outputs of rule30_rng() for its classic seed,	*/
+/* and the subkeys and ciphertext of XR30256 for the key and plaintext	*/
+/* of rule30.crypt.c, both as printed by the code before any		*/
+/* optimization.							*/
+/*									*/
+/* The exit status is 0 only if every kernel agrees with the reference	*/
+/* everywhere, so the harness can gate a build:				*/
+/*									*/
+/*	rule30verify [-n cases] [-g generations] [-s seed]		*/
+/*									*/
+/* compile with:							*/
+/*	gcc -O3 -pthread -o rule30verify rule30.verify.c -lm -lrt	*/
+/************************************************************************/
+
+#include <math.h>
+#include <stddef.h>
+#include <unistd.h>
+
+#include "rule30.rng.h"
+#include "rule30.cone.h"
+#include "rule30.simd.h"
+#include "rule30.ctr.h"
+#include "rule30.dist.h"
+#include "rule30.battery.h"
+#include "rule30.pool.h"
+#include "rule30.index.h"
+#include "rule30.shm.h"
+#include "rule30.crypt.h"
+#include "ca.jump.h"
+#include "ca.domain.h"
+
+#define MAX_REGS	16		/* widest lattice tested, 1024 cells */
+#define NUM_CASES	50		/* random cases per check */
+#define MAX_GENS	2048		/* longest stream per case */
+#define MAX_PIECES	17		/* longest call, in words, when a stream is split */
+#define NUM_ROWS	16		/* kernels per check */
+#define MAX_LANES	8		/* most SIMD lanes */
+#define DOMAIN_THREADS	8		/* most threads a lattice is cut over */
+#define DIST_WORDS	(8*DIST_CHUNK)	/* words drawn per distribution case, for 3 chunks half rejected */
+#define BITS_WORDS	67		/* longest buffer of the bit counts */
+#define POOL_THREADS	4		/* most workers a pool is started with */
+#define INDEX_SNAPSHOTS	16		/* most snapshots in an index */
+#define SHM_CLIENTS	4		/* most clients of a service at once */
+#define SHM_WORDS	(3*SHM_DEPTH*SHM_BLOCK)	/* words read per client, the ring three times over */
+
+/* the results of a check for one kernel */
+struct row {
+
+	const char *kernel;
+	uint64_t cases;
+	uint64_t generations;
+	char failure[160];
+
+};
+
+/* known answers of rule30_rng() seeded with 1234523, as 52-bit mantissas */
+static const uint64_t kat_rng_seed = 1234523;
+static const uint64_t kat_rng[] = {
+
+	0x001B8D594E72EULL, 0x424D80A54E720ULL, 0xB2B0B8AC91B07ULL, 0x48989825589C7ULL, 0xBA038302C5B25ULL,
+	0xE06F3F4D13BC3ULL, 0x9296F8E101042ULL, 0x020848CD1B151ULL, 0xB7F5211F8860BULL
+
+};
+
+/* known answers of XR30256 - the key, plaintext, subkeys K1-K4 and ciphertext of rule30.crypt.c */
+static const unsigned long int kat_key[4] = { 0xA59535D07E192F12UL, 0x82734FB3084C5E05UL, 0x385B8A038D28E669UL, 0xD2BC44A82C395D8EUL };
+static const unsigned long int kat_plaintext[4] = { 0x0101010101010101UL, 0x0202020202020202UL, 0x0303030303030303UL, 0x0404040404040404UL };
+static const unsigned long int kat_subkey[4][4] = {
+
+	{ 0xC46290D1A684D639UL, 0xDF434310B8AA520FUL, 0x4CCD68BFEECB2918UL, 0xA56452519A218336UL },
+	{ 0xB4D09E77E9820EC4UL, 0x91796040DD2E7C51UL, 0x39BA6B64AAD67C6DUL, 0x49D50BCAB40007EEUL },
+	{ 0x9BC35431EB60DA5AUL, 0x23BCE49D10364266UL, 0xEA00761149E29977UL, 0xCDAE3DCC8C6CEF9BUL },
+	{ 0x275B6FCD4B88549FUL, 0x02A3279BCB5A15D3UL, 0x4E69A8D916965A5AUL, 0x72DF7E7A2B5468C5UL }
+
+};
+static const unsigned long int kat_ciphertext[4] = { 0xFFE65120E48FC4F6UL, 0x8858C7277ABEFE8FUL, 0xAFB3A61728DF176EUL, 0x81075D7C09517A42UL };
+
+/* the lattice kernel of ca.h at the widths tested, each compiled for every instruction set */
+#define VERIFY_LATTICE(regs)											\
+	CA_LATTICE_DEFINE(verify_lattice##regs, unsigned long int, regs, WORDSIZE)				\
+	CA_DISPATCH_DEFINE(verify_lattice##regs##_dispatch, verify_lattice##regs##_step,			\
+			   (verify_lattice##regs *lattice, unsigned long int rule), (lattice, rule))
+
+VERIFY_LATTICE(1)
+VERIFY_LATTICE(2)
+VERIFY_LATTICE(3)
+VERIFY_LATTICE(4)
+VERIFY_LATTICE(5)
+VERIFY_LATTICE(7)
+VERIFY_LATTICE(8)
+VERIFY_LATTICE(16)
+
+static const int lattice_regs[] = { 1, 2, 3, 4, 5, 7, 8, 16 };
+
+/* and the kernel for lattices sized at run time */
+CA_DISPATCH_DEFINE(verify_step_dispatch, ca_step,
+		   (const unsigned long int *reg, unsigned long int *next, long int regs, unsigned long int rule), (reg, next, regs, rule))
+
+/* the SIMD lanes at every lane count, each compiled for the instruction set that picks it */
+RULE30_SIMD_DEFINE(verify_simd2, 2, )
+RULE30_SIMD_DEFINE(verify_simd4, 4, CA_TARGET_AVX2)
+RULE30_SIMD_DEFINE(verify_simd8, 8, CA_TARGET_AVX512)
+
+static const int simd_lanes[] = { 2, 4, 8 };
+static const int simd_kernel[] = { CA_KERNEL_SCALAR, CA_KERNEL_AVX2, CA_KERNEL_AVX512 };
+
+#define SIMD_CASE(lanes)	case lanes: {										\
+					struct verify_simd##lanes##_state state;					\
+					verify_simd##lanes##_init(&state, seeds);					\
+					verify_simd##lanes##_fill_u64(&state, buf, n);					\
+					break;										\
+				}
+
+/* n words of the lanes seeded with seeds, by the generator for that many lanes */
+void simd_fill(int lanes, const unsigned long int *seeds, uint64_t *buf, size_t n) {
+
+	switch(lanes) {
+		SIMD_CASE(2);
+		SIMD_CASE(4);
+		SIMD_CASE(8);
+	}
+
+}
+
+#define LATTICE_CASE(regs)	case regs:										\
+					verify_lattice##regs##_dispatch((verify_lattice##regs *)reg, rule);		\
+					break
+
+/* one generation by the kernel under test */
+void lattice_step(unsigned long int *reg, int regs, unsigned long int rule) {
+
+	switch(regs) {
+		LATTICE_CASE(1);
+		LATTICE_CASE(2);
+		LATTICE_CASE(3);
+		LATTICE_CASE(4);
+		LATTICE_CASE(5);
+		LATTICE_CASE(7);
+		LATTICE_CASE(8);
+		LATTICE_CASE(16);
+	}
+
+}
+
+/* one generation by the original per-bit loop: the rule is looked up for the bottom three	*/
+/* cells of every register and the registers are rotated one cell to the right, carrying	*/
+/* across, WORDSIZE times - then the output, built up one bit behind, is rotated back	*/
+void reference_generation(unsigned long int *reg, int regs, unsigned long int rule) {
+
+	unsigned long int in_reg[MAX_REGS], out_reg[MAX_REGS] = { 0 };
+	unsigned long int carry;
+	int bit, i;
+
+	memcpy(in_reg, reg, regs*sizeof(unsigned long int));
+
+	for(bit = 0; bit < WORDSIZE; bit++) {
+
+		/* mask off first three bits and compare with rule */
+		for(i = 0; i < regs; i++)
+			out_reg[i] |= ((rule >> (in_reg[i] & CELL_MASK)) & RHS_ONE) << bit;
+
+		/* rotate all input registers one bit to the right, preserve carry */
+		carry = (in_reg[regs - 1] & RHS_ONE) << (WORDSIZE - 1);
+		for(i = regs - 1; i > 0; i--)
+			in_reg[i] = (in_reg[i] >> RHS_ONE) | ((in_reg[i - 1] & RHS_ONE) << (WORDSIZE - 1));
+		in_reg[0] = (in_reg[0] >> RHS_ONE) | carry;
+
+	}
+
+	/* now must rotate output registers one bit to the left */
+	carry = (out_reg[0] & LHS_ONE) >> (WORDSIZE - 1);
+	for(i = 0; i < regs - 1; i++)
+		out_reg[i] = (out_reg[i] << RHS_ONE) | ((out_reg[i + 1] & LHS_ONE) >> (WORDSIZE - 1));
+	out_reg[regs - 1] = (out_reg[regs - 1] << RHS_ONE) | carry;
+
+	memcpy(reg, out_reg, regs*sizeof(unsigned long int));
+
+}
+
+/* the center cell of the generator's lattice, a byte per generation */
+void reference_center(unsigned long int *reg, unsigned long int rule, unsigned char *bits, size_t count) {
+
+	size_t i;
+
+	for(i = 0; i < count; i++) {
+		reference_generation(reg, RNG_REGS, rule);
+		*(bits + i) = (reg[RNG_REGS / 2] & CENTER_MASK) >> DELTA_CENTER;
+	}
+
+}
+
+/* the XR30256 key schedule - each key word mixed into the others and run through CA256 */
+void reference_key_schedule(const unsigned long int *key, unsigned long int subkey[4][4]) {
+
+	int i, j, g;
+
+	for(i = 0; i < 4; i++) {
+		for(j = 0; j < 4; j++)
+			subkey[i][j] = (i == j) ? *(key + i) : *(key + i) + (*(key + i))*(*(key + j));
+		for(g = 0; g < CA256; g++)
+			reference_generation(subkey[i], 4, RULE30);
+	}
+
+}
+
+/* XR30256 with the subkeys in the order given - first to last to encrypt, last to first	*/
+/* to decrypt.  The lattice carries from one F-function to the next, the halves alternate.	*/
+void reference_cipher(const unsigned long int *subkey[4], const unsigned long int *in, unsigned long int *out) {
+
+	unsigned long int half[2][2] = { { *(in + 0), *(in + 1) }, { *(in + 2), *(in + 3) } };
+	unsigned long int lattice[4] = { *(in + 2), *(in + 3), *(in + 2), *(in + 3) };
+	int round, k, i, g;
+
+	for(round = 0; round < ROUNDS; round++) {
+		for(k = 0; k < 4; k++) {
+
+			for(i = 0; i < 4; i++)
+				lattice[i] ^= *(subkey[k] + i);
+			for(g = 0; g < CA256; g++)
+				reference_generation(lattice, 4, RULE30);
+
+			/* fold the halves together, then the Feistel XOR into alternate halves */
+			lattice[0] ^= lattice[2] ^ half[k & 1][0];
+			lattice[1] ^= lattice[3] ^ half[k & 1][1];
+			lattice[2] = half[k & 1][0] = lattice[0];
+			lattice[3] = half[k & 1][1] = lattice[1];
+
+		}
+	}
+
+	*(out + 0) = half[1][0];
+	*(out + 1) = half[1][1];
+	*(out + 2) = half[0][0];
+	*(out + 3) = half[0][1];
+
+}
+
+/* splitmix64 for the random cases */
+static uint64_t case_state;
+
+uint64_t case_random(void) {
+
+	uint64_t x;
+
+	case_state += 0x9E3779B97F4A7C15ULL;
+	x = case_state;
+	x = (x ^ (x >> 30))*0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27))*0x94D049BB133111EBULL;
+	return(x ^ (x >> 31));
+
+}
+
+/* words of width bits, most significant bit first, a byte per bit */
+void unpack(const uint64_t *word, size_t count, int width, unsigned char *bits) {
+
+	size_t i;
+	int j;
+
+	for(i = 0; i < count; i++)
+		for(j = 0; j < width; j++)
+			*(bits + i*width + j) = (*(word + i) >> (width - 1 - j)) & 1;
+
+}
+
+/* the first bit that differs, or -1 */
+long long int divergence(const unsigned char *a, const unsigned char *b, size_t count) {
+
+	size_t i;
+
+	for(i = 0; i < count; i++)
+		if(*(a + i) != *(b + i))
+			return(i);
+
+	return(-1);
+
+}
+
+/* the mantissa of a double from the generator, exact by construction */
+uint64_t mantissa(double d) {
+
+	return((uint64_t)ldexp(d, DELTA_MANTISSA));
+
+}
+
+void row_init(struct row *row, int count, const char **kernel) {
+
+	int i;
+
+	for(i = 0; i < count; i++) {
+		row[i].kernel = *(kernel + i);
+		row[i].cases = row[i].generations = 0;
+		row[i].failure[0] = '\0';
+	}
+
+}
+
+/* print the rows of a check, returning how many failed */
+int row_report(const char *check, struct row *row, int count) {
+
+	int i, failed = 0;
+
+	for(i = 0; i < count; i++) {
+		printf("%-12s %-8s %8llu %12llu  %s\n", check, row[i].kernel,
+			(unsigned long long)row[i].cases, (unsigned long long)row[i].generations, row[i].failure[0] ? row[i].failure : "ok");
+		failed += (row[i].failure[0] != '\0');
+	}
+
+	return(failed);
+
+}
+
+/* the instruction set variants this CPU runs, scalar first */
+int kernels(const char **name) {
+
+	int i, best = ca_kernel_best();
+
+	for(i = 0; i <= best; i++)
+		*(name + i) = ca_kernel_names[i];
+
+	return(best + 1);
+
+}
+
+/* known answers - the reference and every variant of the generator and cipher */
+int check_kat(void) {
+
+	struct row row[NUM_ROWS];
+	const char *name[NUM_ROWS] = { "ref" };
+	const unsigned long int *order[4];
+	unsigned long int reg[RNG_REGS], subkey[4][4], out[4], in[4];
+	unsigned char bits[DELTA_MANTISSA];
+	struct rule30_rng_state state;
+	struct scheduled_key *skey;
+	double d;
+	size_t i;
+	int count = 1 + kernels(name + 1), k, j, failed = 0;
+
+	/* the generator */
+	row_init(row, count, name);
+	for(j = 0; j < RNG_REGS; j++)
+		reg[j] = kat_rng_seed;
+	for(i = 0; i < sizeof(kat_rng)/sizeof(uint64_t); i++) {
+		reference_center(reg, RULE30, bits, DELTA_MANTISSA);
+		for(j = 0; j < DELTA_MANTISSA; j++)
+			if(bits[j] != ((kat_rng[i] >> (DELTA_MANTISSA - 1 - j)) & 1))
+				break;
+		if((j < DELTA_MANTISSA) && !row[0].failure[0])
+			sprintf(row[0].failure, "output %zu differs at generation %zu", i, i*DELTA_MANTISSA + j + 1);
+		row[0].generations += DELTA_MANTISSA;
+	}
+	row[0].cases = 1;
+	for(k = 1; k < count; k++) {
+		ca_kernel = k - 1;
+		rule30_rng_init(&state, kat_rng_seed);
+		for(i = 0; i < sizeof(kat_rng)/sizeof(uint64_t); i++) {
+			rule30_rng_fill_double_dispatch(&state, &d, 1);
+			if((mantissa(d) != kat_rng[i]) && !row[k].failure[0])
+				sprintf(row[k].failure, "output %zu is 0x%013llX", i, (unsigned long long)mantissa(d));
+			row[k].generations += DELTA_MANTISSA;
+		}
+		row[k].cases = 1;
+	}
+	failed += row_report("kat rng", row, count);
+
+	/* the cipher, with the one key schedule */
+	row_init(row, count, name);
+	reference_key_schedule(kat_key, subkey);
+	for(k = 0; k < 4; k++)
+		order[k] = subkey[k];
+	reference_cipher(order, kat_plaintext, out);
+	if(memcmp(subkey, kat_subkey, sizeof(subkey)))
+		sprintf(row[0].failure, "subkeys differ");
+	else if(memcmp(out, kat_ciphertext, sizeof(out)))
+		sprintf(row[0].failure, "ciphertext differs");
+	row[0].cases = 1;
+	row[0].generations = 4*CA256 + ROUNDS*4*CA256;
+
+	memcpy(in, kat_key, sizeof(in));
+	skey = xr30256_key_schedule(in);
+	for(k = 1; k < count; k++) {
+		ca_kernel = k - 1;
+		memcpy(in, kat_plaintext, sizeof(in));
+		xr30256_encrypt_dispatch(skey, in, out);
+		if(memcmp(skey, kat_subkey, sizeof(kat_subkey)))
+			sprintf(row[k].failure, "subkeys differ");
+		else if(memcmp(out, kat_ciphertext, sizeof(out)))
+			sprintf(row[k].failure, "ciphertext differs");
+		else {
+			xr30256_decrypt_dispatch(skey, out, in);
+			if(memcmp(in, kat_plaintext, sizeof(in)))
+				sprintf(row[k].failure, "decryption differs");
+		}
+		row[k].cases = 1;
+		row[k].generations = 4*CA256 + 2*ROUNDS*4*CA256;
+	}
+	free(skey);
+	failed += row_report("kat xr30256", row, count);
+
+	return(failed);
+
+}
+
+/* the lattice kernel at random widths and rules, compared after every generation */
+int check_lattice(int cases, int max_gens) {
+
+	struct row row[NUM_ROWS];
+	const char *name[NUM_ROWS];
+	unsigned long int reg[MAX_REGS], start[MAX_REGS], rule;
+	static unsigned long int ref[MAX_GENS + 1][MAX_REGS];
+	int count = kernels(name), c, k, g, gens, regs, i;
+
+	row_init(row, count, name);
+	for(c = 0; c < cases; c++) {
+
+		regs = lattice_regs[case_random() % (sizeof(lattice_regs)/sizeof(int))];
+		rule = (c % 4) ? case_random() & 0xFF : RULE30;
+		gens = 1 + case_random() % max_gens;
+		for(i = 0; i < regs; i++)
+			start[i] = case_random();
+
+		memcpy(ref[0], start, sizeof(start));
+		for(g = 1; g <= gens; g++) {
+			memcpy(ref[g], ref[g - 1], sizeof(start));
+			reference_generation(ref[g], regs, rule);
+		}
+
+		for(k = 0; k < count; k++) {
+			if(row[k].failure[0])
+				continue;
+			ca_kernel = k;
+			memcpy(reg, start, sizeof(start));
+			for(g = 1; g <= gens; g++) {
+				lattice_step(reg, regs, rule);
+				if(memcmp(reg, ref[g], regs*sizeof(unsigned long int))) {
+					sprintf(row[k].failure, "case %d, %d cells, rule %lu: diverges at generation %d",
+						c, regs*WORDSIZE, rule, g);
+					break;
+				}
+			}
+			row[k].cases++;
+			row[k].generations += gens;
+		}
+
+	}
+
+	ca_kernel = ca_kernel_best();
+	return(row_report("lattice", row, count));
+
+}
+
+/* ca_step() at every register count, compared after every generation */
+int check_step(int cases, int max_gens) {
+
+	struct row row[NUM_ROWS];
+	const char *name[NUM_ROWS];
+	unsigned long int reg[2][MAX_REGS], start[MAX_REGS], rule;
+	static unsigned long int ref[MAX_GENS + 1][MAX_REGS];
+	int count = kernels(name), c, k, g, gens, regs, i;
+
+	row_init(row, count, name);
+	for(c = 0; c < cases; c++) {
+
+		regs = 1 + case_random() % MAX_REGS;
+		rule = (c % 4) ? case_random() & 0xFF : RULE30;
+		gens = 1 + case_random() % max_gens;
+		for(i = 0; i < regs; i++)
+			start[i] = case_random();
+
+		memcpy(ref[0], start, sizeof(start));
+		for(g = 1; g <= gens; g++) {
+			memcpy(ref[g], ref[g - 1], sizeof(start));
+			reference_generation(ref[g], regs, rule);
+		}
+
+		for(k = 0; k < count; k++) {
+			if(row[k].failure[0])
+				continue;
+			ca_kernel = k;
+			memcpy(reg[0], start, sizeof(start));
+			for(g = 1; g <= gens; g++) {
+				verify_step_dispatch(reg[(g - 1) & 1], reg[g & 1], regs, rule);
+				if(memcmp(reg[g & 1], ref[g], regs*sizeof(unsigned long int))) {
+					sprintf(row[k].failure, "case %d, %d cells, rule %lu: diverges at generation %d",
+						c, regs*WORDSIZE, rule, g);
+					break;
+				}
+			}
+			row[k].cases++;
+			row[k].generations += gens;
+		}
+
+	}
+
+	ca_kernel = ca_kernel_best();
+	return(row_report("step", row, count));
+
+}
+
+/* the lattice cut into chunks over threads (ca.domain.h), advanced in random pieces and	*/
+/* read back at the end of each - a thread count for each case, up to one per register	*/
+int check_domain(int cases, int max_gens) {
+
+	struct row row[NUM_ROWS];
+	const char *name[NUM_ROWS];
+	struct ca_domain domain;
+	unsigned long int reg[MAX_REGS], start[MAX_REGS], rule;
+	static unsigned long int ref[MAX_GENS + 1][MAX_REGS];
+	int count = kernels(name), c, k, g, piece, gens, regs, threads, i;
+
+	row_init(row, count, name);
+	for(c = 0; c < cases; c++) {
+
+		regs = 1 + case_random() % MAX_REGS;
+		threads = 1 + case_random() % ((regs < DOMAIN_THREADS) ? regs : DOMAIN_THREADS);
+		rule = (c % 4) ? case_random() & 0xFF : RULE30;
+		gens = 1 + case_random() % max_gens;
+		for(i = 0; i < regs; i++)
+			start[i] = case_random();
+
+		memcpy(ref[0], start, sizeof(start));
+		for(g = 1; g <= gens; g++) {
+			memcpy(ref[g], ref[g - 1], sizeof(start));
+			reference_generation(ref[g], regs, rule);
+		}
+
+		for(k = 0; k < count; k++) {
+			if(row[k].failure[0])
+				continue;
+			ca_kernel = k;
+			if(ca_domain_start(&domain, threads, start, regs, rule)) {
+				sprintf(row[k].failure, "case %d: couldn't start %d threads", c, threads);
+				continue;
+			}
+			for(g = 0; g < gens; g += piece) {
+				piece = 1 + case_random() % (gens - g);
+				ca_domain_advance(&domain, piece);
+				ca_domain_read(&domain, reg);
+				if(memcmp(reg, ref[g + piece], regs*sizeof(unsigned long int))) {
+					sprintf(row[k].failure, "case %d, %d cells, %d threads, rule %lu: diverges by generation %d",
+						c, regs*WORDSIZE, threads, rule, g + piece);
+					break;
+				}
+			}
+			ca_domain_stop(&domain);
+			row[k].cases++;
+			row[k].generations += gens;
+		}
+
+	}
+
+	ca_kernel = ca_kernel_best();
+	return(row_report("domain", row, count));
+
+}
+
+/* the generator's center column - the bulk calls in every variant, fed the stream in	*/
+/* random pieces, rule30_rng_next() and rule30_rng_advance(), the light-cone tables for	*/
+/* random rules and each lane of the SIMD generator					*/
+int check_center(int cases, int max_gens) {
+
+	struct row row[NUM_ROWS];
+	const char *name[NUM_ROWS];
+	struct rule30_rng_state start, state;
+	static struct rule30_cone cone;
+	unsigned long int reg[RNG_REGS], seeds[MAX_LANES], rule;
+	static uint64_t buf[MAX_GENS/DELTA_MANTISSA + 1];
+	static double dbl[MAX_GENS/DELTA_MANTISSA + 1];
+	static unsigned char ref[MAX_LANES][MAX_GENS + 64], bits[MAX_GENS + 64];
+	static uint64_t lanes[MAX_LANES*(MAX_GENS/64 + 1)];
+	static const char *lane_name[] = { "simd2", "simd4", "simd8" };
+	size_t words, doubles, i, piece, n;
+	long long int diff;
+	int count = kernels(name), fixed, simd, c, k, v, lane, failed = 0;
+
+	/* the bulk words in each variant, then the doubles, then the calls without variants and	*/
+	/* the SIMD lane counts this CPU runs							*/
+	fixed = 2*count;
+	name[2*count] = "next";
+	name[2*count + 1] = "cone";
+	for(simd = 0; (simd < 3) && (simd_kernel[simd] <= ca_kernel_best()); simd++)
+		name[2*count + 2 + simd] = lane_name[simd];
+	for(k = 0; k < count; k++)
+		name[count + k] = name[k];
+	row_init(row, 2*count + 2 + simd, name);
+
+	for(c = 0; c < cases; c++) {
+
+		if(c % 2)
+			rule30_rng_init(&start, case_random() | 1);
+		else
+			rule30_rng_init_full(&start, case_random());
+		words = 1 + case_random() % (max_gens/64);
+		doubles = 64*words/DELTA_MANTISSA;
+
+		memcpy(reg, start.reg, sizeof(reg));
+		reference_center(reg, RULE30, ref[0], 64*words);
+
+		for(k = 0; k < count; k++) {
+
+			ca_kernel = k;
+
+			if(!row[k].failure[0]) {
+				state = start;
+				for(i = 0; i < words; i += piece) {
+					piece = 1 + case_random() % MAX_PIECES;
+					if(piece > words - i)
+						piece = words - i;
+					rule30_rng_fill_u64_dispatch(&state, buf + i, piece);
+				}
+				unpack(buf, words, 64, bits);
+				if((diff = divergence(bits, ref[0], 64*words)) >= 0)
+					sprintf(row[k].failure, "case %d: diverges at generation %lld", c, diff + 1);
+				row[k].cases++;
+				row[k].generations += 64*words;
+			}
+
+			if(!row[count + k].failure[0] && doubles) {
+				state = start;
+				for(i = 0; i < doubles; i += piece) {
+					piece = 1 + case_random() % MAX_PIECES;
+					if(piece > doubles - i)
+						piece = doubles - i;
+					rule30_rng_fill_double_dispatch(&state, dbl + i, piece);
+				}
+				for(i = 0; i < doubles; i++)
+					buf[i] = mantissa(dbl[i]);
+				unpack(buf, doubles, DELTA_MANTISSA, bits);
+				if((diff = divergence(bits, ref[0], DELTA_MANTISSA*doubles)) >= 0)
+					sprintf(row[count + k].failure, "case %d: diverges at generation %lld", c, diff + 1);
+				row[count + k].cases++;
+				row[count + k].generations += DELTA_MANTISSA*doubles;
+			}
+
+		}
+
+		/* single doubles, skipping every third one */
+		if(!row[fixed].failure[0] && doubles) {
+			state = start;
+			for(i = 0; i < doubles; i++) {
+				if(i % 3 == 1) {
+					rule30_rng_advance(&state, DELTA_MANTISSA);
+					buf[i] = 0;
+				}
+				else
+					buf[i] = mantissa(rule30_rng_next(&state));
+			}
+			unpack(buf, doubles, DELTA_MANTISSA, bits);
+			for(i = 1; i < doubles; i += 3)
+				memcpy(bits + i*DELTA_MANTISSA, ref[0] + i*DELTA_MANTISSA, DELTA_MANTISSA);
+			if((diff = divergence(bits, ref[0], DELTA_MANTISSA*doubles)) >= 0)
+				sprintf(row[fixed].failure, "case %d: diverges at generation %lld", c, diff + 1);
+			row[fixed].cases++;
+			row[fixed].generations += DELTA_MANTISSA*doubles;
+		}
+
+		/* the tables for a random rule, against the reference for that rule */
+		if(!row[fixed + 1].failure[0]) {
+			rule = (c % 4) ? case_random() & 0xFF : RULE30;
+			rule30_cone_init(&cone, rule);
+			memcpy(reg, start.reg, sizeof(reg));
+			reference_center(reg, rule, ref[1], 64*words);
+			state = start;
+			for(i = 0; i < words; i += piece) {
+				piece = 1 + case_random() % MAX_PIECES;
+				if(piece > words - i)
+					piece = words - i;
+				rule30_cone_fill_u64(&cone, &state, buf + i, piece);
+			}
+			unpack(buf, words, 64, bits);
+			if((diff = divergence(bits, ref[1], 64*words)) >= 0)
+				sprintf(row[fixed + 1].failure, "case %d, rule %lu: diverges at generation %lld", c, rule, diff + 1);
+			row[fixed + 1].cases++;
+			row[fixed + 1].generations += 64*words;
+		}
+
+		/* a seed per lane, the first the one above */
+		for(lane = 0; lane < MAX_LANES; lane++) {
+			seeds[lane] = lane ? case_random() | 1 : start.reg[0];
+			for(i = 0; i < RNG_REGS; i++)
+				reg[i] = seeds[lane];
+			reference_center(reg, RULE30, ref[lane], 64*words);
+		}
+
+		/* each lane count, with a last group that is short by up to lanes - 1 words, whose	*/
+		/* surplus must be dropped without being written					*/
+		for(v = 0; v < simd; v++) {
+			if(row[fixed + 2 + v].failure[0])
+				continue;
+			n = simd_lanes[v]*words - case_random() % simd_lanes[v];
+			memset(lanes, 0xA5, sizeof(lanes));
+			simd_fill(simd_lanes[v], seeds, lanes, n);
+			for(lane = 0; lane < simd_lanes[v]; lane++) {
+				for(i = 0; i < words; i++)
+					buf[i] = lanes[i*simd_lanes[v] + lane];
+				unpack(buf, words, 64, bits);
+				if(((diff = divergence(bits, ref[lane], 64*(words - (lane >= n - simd_lanes[v]*(words - 1))))) >= 0)) {
+					sprintf(row[fixed + 2 + v].failure, "case %d, lane %d: diverges at generation %lld", c, lane, diff + 1);
+					break;
+				}
+			}
+			for(i = n; i < simd_lanes[v]*words; i++)
+				if(lanes[i] != 0xA5A5A5A5A5A5A5A5ULL)
+					sprintf(row[fixed + 2 + v].failure, "case %d: word %zu written past the %zu asked for", c, i, n);
+			row[fixed + 2 + v].cases++;
+			row[fixed + 2 + v].generations += simd_lanes[v]*64*words;
+		}
+
+	}
+
+	failed += row_report("center", row, count);
+	failed += row_report("double", row + count, count);
+	failed += row_report("center", row + fixed, 2 + simd);
+	ca_kernel = ca_kernel_best();
+
+	return(failed);
+
+}
+
+/* random tap sets harvested from a fully seeded lattice - a call drops the bits of its	*/
+/* last generation that do not fit, so the reference is cut into the same pieces		*/
+int check_taps(int cases, int max_gens) {
+
+	struct row row[NUM_ROWS];
+	const char *name[NUM_ROWS];
+	struct rule30_rng_state start, state;
+	struct rule30_taps taps;
+	unsigned long int reg[RNG_REGS];
+	int columns[64], taken[RNG_REGS*WORDSIZE];
+	static uint64_t buf[MAX_GENS/64 + 1];
+	static unsigned char ref[MAX_GENS + 64], bits[MAX_GENS + 128];
+	static uint64_t generation[MAX_GENS + 64];
+	size_t piece[MAX_GENS/64 + 1], pieces, words, i, j, filled;
+	uint64_t g;
+	long long int diff;
+	int count = kernels(name), c, k, t, r, col;
+
+	row_init(row, count, name);
+	for(c = 0; c < cases; c++) {
+
+		rule30_rng_init_full(&start, case_random());
+		if(c % 4) {
+			memset(taken, 0, sizeof(taken));
+			t = 1 + case_random() % 64;
+			for(i = 0; i < (size_t)t; i++) {
+				do
+					col = case_random() % (RNG_REGS*WORDSIZE);
+				while(taken[col]);
+				taken[col] = 1;
+				columns[i] = col;
+			}
+			rule30_taps_init(&taps, columns, t);
+		}
+		else
+			rule30_taps_default(&taps);
+
+		words = 1 + case_random() % (max_gens/64);
+		for(pieces = i = 0; i < words; i += piece[pieces++]) {
+			piece[pieces] = 1 + case_random() % MAX_PIECES;
+			if(piece[pieces] > words - i)
+				piece[pieces] = words - i;
+		}
+
+		/* the tapped cells of each register, right to left */
+		memcpy(reg, start.reg, sizeof(reg));
+		for(i = filled = g = 0; i < pieces; i++) {
+			for(j = 0; j < 64*piece[i]; g++) {
+				reference_generation(reg, RNG_REGS, RULE30);
+				for(r = 0; r < RNG_REGS; r++)
+					for(col = WORDSIZE - 1; col >= 0; col--)
+						if((taps.mask[r] >> (WORDSIZE - 1 - col)) & RHS_ONE) {
+							generation[filled + j] = g + 1;
+							bits[j++] = (reg[r] >> (WORDSIZE - 1 - col)) & RHS_ONE;
+						}
+			}
+			memcpy(ref + filled, bits, 64*piece[i]);
+			filled += 64*piece[i];
+		}
+
+		for(k = 0; k < count; k++) {
+			if(row[k].failure[0])
+				continue;
+			ca_kernel = k;
+			state = start;
+			for(i = j = 0; i < pieces; j += piece[i++])
+				rule30_rng_fill_u64_taps_dispatch(&state, &taps, buf + j, piece[i]);
+			unpack(buf, words, 64, bits);
+			if((diff = divergence(bits, ref, 64*words)) >= 0)
+				sprintf(row[k].failure, "case %d, %d taps: diverges at generation %llu",
+					c, taps.count, (unsigned long long)generation[diff]);
+			row[k].cases++;
+			row[k].generations += g;
+		}
+
+	}
+
+	ca_kernel = ca_kernel_best();
+	return(row_report("taps", row, count));
+
+}
+
+/* the next word for a reference sampler, or 0 past the words drawn for the case */
+uint64_t reference_word(const uint64_t *word, size_t *next) {
+
+	return((*next < DIST_WORDS) ? *(word + (*next)++) : 0);
+
+}
+
+/* Lemire's multiply-shift as published: the threshold 2^32 % range, by a divide, only	*/
+/* when the low half of the product is below range, and a loop per rejection		*/
+uint32_t reference_bounded(const uint64_t *word, size_t *half, uint32_t range) {
+
+	uint64_t product;
+	uint32_t x;
+
+	while(1) {
+		x = (*half < 2*DIST_WORDS) ? (uint32_t)(*(word + *half/2) >> ((*half % 2) ? 0 : 32)) : 0;
+		(*half)++;
+		product = (uint64_t)x*range;
+		if(((uint32_t)product >= range) || ((uint32_t)product >= ((1ULL << 32) - range) % range))
+			return(product >> 32);
+	}
+
+}
+
+uint64_t reference_bounded64(const uint64_t *word, size_t *next, uint64_t range) {
+
+	unsigned __int128 product;
+
+	while(1) {
+		product = (unsigned __int128)reference_word(word, next)*range;
+		if(((uint64_t)product >= range) || ((uint64_t)product >= ((((unsigned __int128)1) << 64) - range) % range))
+			return(product >> 64);
+	}
+
+}
+
+/* Marsaglia and Tsang's ziggurats a variate at a time, drawing the words of the wedge	*/
+/* and tail tests from next on								*/
+double reference_normal(const struct rule30_zig *zig, const uint64_t *word, size_t *next, uint64_t w) {
+
+	double u, x, y;
+	int i;
+
+	while(1) {
+
+		i = w & (ZIG_NORMAL_LAYERS - 1);
+		u = 2.0*ldexp((double)(w >> 12), -52) - 1.0;
+		x = u*zig->normal_x[i];
+		if(fabs(u) < zig->normal_r[i])
+			return(x);
+
+		if(!i) {
+			do {
+				x = log(1.0 - ldexp((double)(reference_word(word, next) >> 11), -53))/ZIG_NORMAL_R;
+				y = log(1.0 - ldexp((double)(reference_word(word, next) >> 11), -53));
+			} while(-2.0*y < x*x);
+			return((u < 0) ? x - ZIG_NORMAL_R : ZIG_NORMAL_R - x);
+		}
+
+		y = ldexp((double)(reference_word(word, next) >> 12), -52);
+		if(exp(-0.5*(zig->normal_x[i + 1]*zig->normal_x[i + 1] - x*x))
+		   + y*(exp(-0.5*(zig->normal_x[i]*zig->normal_x[i] - x*x)) - exp(-0.5*(zig->normal_x[i + 1]*zig->normal_x[i + 1] - x*x))) < 1.0)
+			return(x);
+
+		w = reference_word(word, next);
+
+	}
+
+}
+
+double reference_exponential(const struct rule30_zig *zig, const uint64_t *word, size_t *next, uint64_t w) {
+
+	double u, x, y;
+	int i;
+
+	while(1) {
+
+		i = w & (ZIG_EXP_LAYERS - 1);
+		u = ldexp((double)(w >> 12), -52);
+		x = u*zig->exp_x[i];
+		if(u < zig->exp_r[i])
+			return(x);
+
+		if(!i)
+			return(ZIG_EXP_R - log(1.0 - ldexp((double)(reference_word(word, next) >> 11), -53)));
+
+		y = ldexp((double)(reference_word(word, next) >> 12), -52);
+		if(exp(-(zig->exp_x[i + 1] - x)) + y*(exp(-(zig->exp_x[i] - x)) - exp(-(zig->exp_x[i + 1] - x))) < 1.0)
+			return(x);
+
+		w = reference_word(word, next);
+
+	}
+
+}
+
+/* the distributions of rule30.dist.h against the samplers above on the words of	*/
+/* rule30_rng_fill_u64(), checked against the reference by check_center(): the values,	*/
+/* and the word the stream resumes at.  The fill calls draw DIST_CHUNK words at a time	*/
+/* and the ziggurats' slow paths draw after the whole chunk, so the reference does too.	*/
+/* The layer tables must add up to the areas of the densities.				*/
+int check_dist(int cases) {
+
+	const char *name[] = { "double", "float", "bound32", "bound64", "normal", "exp" };
+	struct row row[6];
+	struct rule30_rng_state start, state;
+	static struct rule30_zig zig;
+	static uint64_t word[DIST_WORDS], value[3*DIST_CHUNK], expect[3*DIST_CHUNK];
+	static double dbl[3*DIST_CHUNK], ref[3*DIST_CHUNK];
+	static float flt[3*DIST_CHUNK];
+	static uint32_t bounded[3*DIST_CHUNK];
+	uint64_t range = 0, after;
+	size_t n, used = 0, i, first, count, chunk;
+	char what[32];
+	double top;
+	int c, k;
+
+	row_init(row, 6, name);
+	rule30_zig_init(&zig);
+
+	top = zig.normal_x[ZIG_NORMAL_LAYERS - 1];
+	if(fabs(top*(1.0 - exp(-0.5*top*top))/ZIG_NORMAL_V - 1.0) > 1.0e-6)
+		sprintf(row[4].failure, "the top layer's area is %g, not %g", top*(1.0 - exp(-0.5*top*top)), ZIG_NORMAL_V);
+	top = zig.exp_x[ZIG_EXP_LAYERS - 1];
+	if(fabs(top*(1.0 - exp(-top))/ZIG_EXP_V - 1.0) > 1.0e-6)
+		sprintf(row[5].failure, "the top layer's area is %g, not %g", top*(1.0 - exp(-top)), ZIG_EXP_V);
+
+	for(c = 0; c < cases; c++) {
+
+		rule30_rng_init_full(&start, case_random());
+		state = start;
+		rule30_rng_fill_u64(&state, word, DIST_WORDS);
+		n = 1 + case_random() % (3*DIST_CHUNK);
+
+		for(k = 0; k < 6; k++) {
+
+			if(row[k].failure[0])
+				continue;
+			state = start;
+
+			switch(k) {
+
+				case 0:
+					rule30_dist_fill_double(&state, dbl, n);
+					for(i = 0; i < n; i++)
+						ref[i] = ldexp((double)(word[i] >> 11), -53);
+					used = n;
+					break;
+
+				case 1:
+					rule30_dist_fill_float(&state, flt, n);
+					for(i = 0; i < n; i++) {
+						dbl[i] = flt[i];
+						ref[i] = ldexpf((float)((uint32_t)(word[i/2] >> ((i % 2) ? 0 : 32)) >> 8), -24);
+					}
+					used = (n + 1)/2;
+					break;
+
+				/* small, power of two, rejecting about half and any range */
+				case 2:
+					switch(c % 4) {
+						case 0: range = 1 + case_random() % 16; break;
+						case 1: range = 1ULL << (case_random() % 32); break;
+						case 2: range = 0x80000001ULL + case_random() % 0x10000; break;
+						default: range = (uint32_t)case_random() | 1;
+					}
+					rule30_dist_fill_bounded(&state, (uint32_t)range, bounded, n);
+					for(i = 0, used = 0; i < n; i++) {
+						value[i] = bounded[i];
+						expect[i] = reference_bounded(word, &used, (uint32_t)range);
+					}
+					used = (used + 1)/2;
+					break;
+
+				case 3:
+					switch(c % 4) {
+						case 0: range = 1 + case_random() % 16; break;
+						case 1: range = 1ULL << (case_random() % 64); break;
+						case 2: range = 0x8000000000000001ULL + case_random() % 0x10000; break;
+						default: range = case_random() | 1;
+					}
+					rule30_dist_fill_bounded64(&state, range, value, n);
+					for(i = 0, used = 0; i < n; i++)
+						expect[i] = reference_bounded64(word, &used, range);
+					break;
+
+				case 4:
+				case 5:
+					if(k == 4)
+						rule30_dist_fill_normal(&state, &zig, dbl, n);
+					else
+						rule30_dist_fill_exponential(&state, &zig, dbl, n);
+					for(first = 0, used = 0; first < n; first += count) {
+						count = (n - first < DIST_CHUNK) ? n - first : DIST_CHUNK;
+						chunk = used;
+						used += count;
+						for(i = first; i < first + count; i++)
+							ref[i] = (k == 4) ? reference_normal(&zig, word, &used, word[chunk + i - first])
+									  : reference_exponential(&zig, word, &used, word[chunk + i - first]);
+					}
+					break;
+
+			}
+
+			for(i = 0; i < n; i++)
+				if(((k == 2) || (k == 3)) ? (value[i] != expect[i]) : (dbl[i] != ref[i]))
+					break;
+			rule30_rng_fill_u64(&state, &after, 1);
+			if((k == 2) || (k == 3))
+				sprintf(what, ", range %llu", (unsigned long long)range);
+			else
+				what[0] = '\0';
+			if(i < n)
+				sprintf(row[k].failure, "case %d%s: number %zu of %zu differs", c, what, i, n);
+			else if((used >= DIST_WORDS) || (after != word[used]))
+				sprintf(row[k].failure, "case %d%s: the stream does not resume at word %zu", c, what, used);
+			row[k].cases++;
+			row[k].generations += 64*used;
+
+		}
+
+	}
+
+	return(row_report("dist", row, 6));
+
+}
+
+/* the battery's bit counts in each variant against a count of every bit, on buffers of	*/
+/* random words and of long runs, with the counts already holding something		*/
+int check_bits(int cases) {
+
+	struct row row[NUM_ROWS];
+	const char *name[NUM_ROWS];
+	uint64_t buf[BITS_WORDS], counts[2], expect[2];
+	size_t n, i;
+	int count = kernels(name), c, k, bit, last, next;
+
+	row_init(row, count, name);
+	for(c = 0; c < cases; c++) {
+
+		n = case_random() % (BITS_WORDS + 1);
+		for(i = 0; i < n; i++)
+			buf[i] = (c % 2) ? case_random() : -(case_random() % 2);
+
+		expect[0] = c;
+		expect[1] = 2*c;
+		for(i = 0, last = -1; i < n; i++)
+			for(bit = WORDSIZE - 1; bit >= 0; bit--) {
+				next = (buf[i] >> bit) & 1;
+				expect[0] += next;
+				expect[1] += (last >= 0) && (next != last);
+				last = next;
+			}
+
+		for(k = 0; k < count; k++) {
+			if(row[k].failure[0])
+				continue;
+			ca_kernel = k;
+			counts[0] = c;
+			counts[1] = 2*c;
+			count_bits_dispatch(buf, n, counts);
+			if((counts[0] != expect[0]) || (counts[1] != expect[1]))
+				sprintf(row[k].failure, "case %d, %zu words: %llu ones and %llu transitions, not %llu and %llu", c, n,
+					(unsigned long long)(counts[0] - c), (unsigned long long)(counts[1] - 2*c),
+					(unsigned long long)(expect[0] - c), (unsigned long long)(expect[1] - 2*c));
+			row[k].cases++;
+			row[k].generations += 64*n;
+		}
+
+	}
+	ca_kernel = ca_kernel_best();
+
+	return(row_report("bits", row, count));
+
+}
+
+/* the producer pool with a random number of workers, its rings drained in a random	*/
+/* interleaving and wrapped several times over - the blocks of ring i are the stream of	*/
+/* a lattice seeded with seed + i*POOL_SPREAD, harvested from the default taps a block	*/
+/* per call									*/
+int check_pool(int cases) {
+
+	struct row row[1];
+	const char *name[1] = { "scalar" };
+	struct rule30_pool pool;
+	struct rule30_rng_state state[POOL_THREADS];
+	struct rule30_taps taps;
+	static uint64_t ref[POOL_BLOCK];
+	const uint64_t *block;
+	unsigned long int seed;
+	int blocks[POOL_THREADS], taken[POOL_THREADS];
+	int c, i, w, workers, left;
+
+	rule30_taps_default(&taps);
+	row_init(row, 1, name);
+	for(c = 0; c < cases && !row[0].failure[0]; c++) {
+
+		seed = case_random();
+		workers = 1 + case_random() % POOL_THREADS;
+		if(rule30_pool_start(&pool, workers, seed)) {
+			sprintf(row[0].failure, "case %d: couldn't start %d workers", c, workers);
+			break;
+		}
+
+		for(i = left = 0; i < workers; i++) {
+			rule30_rng_init_full(&state[i], seed + i*POOL_SPREAD);
+			blocks[i] = 1 + case_random() % (3*POOL_SLOTS);
+			taken[i] = 0;
+			left += blocks[i];
+		}
+
+		while(left && !row[0].failure[0]) {
+			i = case_random() % workers;
+			if(taken[i] == blocks[i])
+				continue;
+			if(!(case_random() % 2) || !(block = rule30_pool_try_acquire(&pool, i)))
+				block = rule30_pool_acquire(&pool, i);
+			rule30_rng_fill_u64_taps(&state[i], &taps, ref, POOL_BLOCK);
+			for(w = 0; (w < POOL_BLOCK) && (*(block + w) == ref[w]); w++);
+			if(w < POOL_BLOCK)
+				sprintf(row[0].failure, "case %d, %d workers, ring %d block %d: diverges at generation %llu",
+					c, workers, i, taken[i],
+					(unsigned long long)((((uint64_t)taken[i]*POOL_BLOCK + w)*64 + __builtin_clzll(*(block + w) ^ ref[w]))/taps.count + 1));
+			rule30_pool_release(&pool, i);
+			row[0].generations += POOL_BLOCK*64/taps.count;
+			taken[i]++;
+			left--;
+		}
+		rule30_pool_stop(&pool);
+		row[0].cases++;
+
+	}
+
+	return(row_report("pool", row, 1));
+
+}
+
+/* an index file against stepping from the seed: every snapshot and random positions up	*/
+/* to an interval past the last, after a build in one go, an extension of a shorter	*/
+/* index, a build killed part way (the count behind garbage snapshots) and a file cut	*/
+/* back to a snapshot - and an index of another seed and a foreign file with a zero	*/
+/* count must be refused untouched							*/
+int check_index(int cases, int max_gens) {
+
+	struct row row[1];
+	const char *name[1] = { "scalar" };
+	struct rule30_index index;
+	struct rule30_rng_state start, state;
+	unsigned long int reg[RNG_REGS], seed;
+	static unsigned char image[INDEX_BYTES(INDEX_SNAPSHOTS)], again[INDEX_BYTES(INDEX_SNAPSHOTS)];
+	char path[] = "/tmp/rule30verify.XXXXXX";
+	uint64_t interval, count, resume, g, end;
+	size_t length, i;
+	int c, full, fd, r, status;
+
+	row_init(row, 1, name);
+	fd = mkstemp(path);
+	if(fd < 0) {
+		sprintf(row[0].failure, "couldn't create %s", path);
+		return(row_report("index", row, 1));
+	}
+
+	for(c = 0; c < cases && !row[0].failure[0]; c++) {
+
+		seed = case_random();
+		full = c % 2;
+		interval = 1 + case_random() % (max_gens/INDEX_SNAPSHOTS);
+		count = 1 + case_random() % INDEX_SNAPSHOTS;
+		resume = 1 + case_random() % count;
+		length = INDEX_BYTES(count);
+
+		/* built in one go, or short and extended, or cut back or killed and resumed */
+		status = ftruncate(fd, 0) || rule30_index_build(path, seed, full, interval, ((c % 4) == 1) ? resume : count);
+		if((c % 4) == 2)
+			status = status || ftruncate(fd, INDEX_BYTES(resume));
+		if((c % 4) == 3) {
+			for(i = 0; i < length; i++)
+				image[i] = case_random();
+			status = status || (pwrite(fd, image, length - INDEX_BYTES(resume), INDEX_BYTES(resume)) != (ssize_t)(length - INDEX_BYTES(resume)));
+		}
+		if((c % 4) > 1)
+			status = status || (pwrite(fd, &resume, sizeof(resume), offsetof(struct rule30_index_header, count)) != sizeof(resume));
+		if(c % 4)
+			status = status || rule30_index_build(path, seed, full, interval, count);
+		if(status || rule30_index_open(&index, path)) {
+			sprintf(row[0].failure, "case %d, %llu snapshots resumed from %llu: the build failed",
+				c, (unsigned long long)count, (unsigned long long)resume);
+			break;
+		}
+
+		/* every snapshot and about 1 in 16 other generations */
+		if(full)
+			rule30_rng_init_full(&start, seed);
+		else
+			rule30_rng_init(&start, seed);
+		memcpy(reg, start.reg, sizeof(reg));
+		end = (count + 1)*interval;
+		for(g = 0; g < end; g++) {
+			if(!(g % interval) || !(case_random() % 16)) {
+				rule30_index_seek(&index, g, &state);
+				if(memcmp(state.reg, reg, sizeof(reg))) {
+					sprintf(row[0].failure, "case %d, interval %llu, %llu snapshots resumed from %llu: diverges at generation %llu",
+						c, (unsigned long long)interval, (unsigned long long)count, (unsigned long long)resume, (unsigned long long)g);
+					break;
+				}
+			}
+			reference_generation(reg, RNG_REGS, RULE30);
+		}
+		if(!row[0].failure[0] && (index.count != count))
+			sprintf(row[0].failure, "case %d: %llu snapshots instead of %llu", c, (unsigned long long)index.count, (unsigned long long)count);
+		rule30_index_close(&index);
+		row[0].cases++;
+		row[0].generations += end;
+
+		/* another seed, then noise with a zero count in place of the header */
+		if(((c % 4) == 0) && !row[0].failure[0]) {
+			for(r = 0; r < 2; r++) {
+				if(r) {
+					for(i = 0; i < length; i++)
+						image[i] = case_random();
+					memset(image + offsetof(struct rule30_index_header, count), 0, sizeof(uint64_t));
+					if(pwrite(fd, image, length, 0) != (ssize_t)length)
+						break;
+				}
+				if(pread(fd, again, length, 0) != (ssize_t)length)
+					break;
+				if(!rule30_index_build(path, r ? seed : seed ^ 1, full, interval, count) ||
+				   (pread(fd, image, length, 0) != (ssize_t)length) || memcmp(image, again, length)) {
+					sprintf(row[0].failure, "case %d: %s was not refused untouched", c, r ? "a foreign file" : "an index of another seed");
+					break;
+				}
+			}
+		}
+
+	}
+
+	close(fd);
+	unlink(path);
+	return(row_report("index", row, 1));
+
+}
+
+/* a daemon worker of rule30.shm.h serving a private object from a thread - clients	*/
+/* attach for random substreams, read them in random pieces in turn, and detach and	*/
+/* reattach to rewind - substream s must be the counter mode from word s << 40 on,	*/
+/* and a substream of 2^24 or more, which would wrap, must be refused			*/
+void *shm_serve(void *arg) {
+
+	struct rule30_shm *shm = (struct rule30_shm *)arg;
+
+	while(atomic_load_explicit(&shm->running, memory_order_relaxed))
+		if(!rule30_shm_serve(shm, 0, 1, 0))
+			sched_yield();
+
+	return(NULL);
+
+}
+
+int check_shm(int cases) {
+
+	struct row row[1];
+	const char *name[1] = { "scalar" };
+	struct rule30_shm *shm;
+	struct rule30_shm_client client[SHM_CLIENTS];
+	struct rule30_ctr_key key;
+	static uint64_t buf[SHM_WORDS], ref[SHM_CLIENTS][SHM_WORDS];
+	uint64_t substream[SHM_CLIENTS], read[SHM_CLIENTS];
+	int rewound[SHM_CLIENTS];
+	unsigned long int seed;
+	size_t size = rule30_shm_size(SHM_CLIENTS), piece, i;
+	char path[32];
+	pthread_t thread;
+	int c, k, clients, fd, left;
+
+	row_init(row, 1, name);
+	sprintf(path, "/rule30verify.%d", (int)getpid());
+	for(c = 0; c < cases && !row[0].failure[0]; c++) {
+
+		fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+		if((fd < 0) || ftruncate(fd, size) ||
+		   ((shm = (struct rule30_shm *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED)) {
+			sprintf(row[0].failure, "couldn't create shared memory %s", path);
+			if(fd >= 0) {
+				close(fd);
+				shm_unlink(path);
+			}
+			break;
+		}
+		close(fd);
+		seed = case_random();
+		rule30_shm_init(shm, SHM_CLIENTS, seed, getpid());
+		if(pthread_create(&thread, NULL, shm_serve, shm)) {
+			sprintf(row[0].failure, "couldn't start the daemon thread");
+			munmap(shm, size);
+			shm_unlink(path);
+			break;
+		}
+
+		/* a substream that would wrap onto another is refused */
+		if(!rule30_shm_attach(&client[0], path, 1ULL << (64 - SHM_SUBSTREAM_SHIFT))) {
+			sprintf(row[0].failure, "case %d: substream 2^%d was accepted", c, 64 - SHM_SUBSTREAM_SHIFT);
+			rule30_shm_detach(&client[0]);
+		}
+
+		/* the reference from the seed alone, not from the object */
+		rule30_ctr_init(&key, seed);
+		clients = row[0].failure[0] ? 0 : 1 + case_random() % SHM_CLIENTS;
+		for(k = 0; k < clients; k++) {
+			substream[k] = (k && (c % 2)) ? case_random() >> SHM_SUBSTREAM_SHIFT : case_random() % 64;
+			rule30_ctr_fill_u64(&key, substream[k] << SHM_SUBSTREAM_SHIFT, ref[k], SHM_WORDS);
+			if(rule30_shm_attach(&client[k], path, substream[k])) {
+				sprintf(row[0].failure, "case %d: client %d couldn't attach", c, k);
+				break;
+			}
+			read[k] = 0;
+			rewound[k] = 0;
+		}
+		clients = k;
+
+		/* turn about, each reattaching half way through once */
+		for(left = clients; left && !row[0].failure[0]; ) {
+			k = case_random() % clients;
+			if(read[k] == SHM_WORDS)
+				continue;
+			piece = 1 + case_random() % (SHM_BLOCK + SHM_BLOCK/2);
+			if(piece > SHM_WORDS - read[k])
+				piece = SHM_WORDS - read[k];
+			if(rule30_shm_fill_u64(&client[k], buf, piece) != piece) {
+				sprintf(row[0].failure, "case %d, substream %llu: the stream stopped at word %llu",
+					c, (unsigned long long)substream[k], (unsigned long long)read[k]);
+				break;
+			}
+			for(i = 0; (i < piece) && (buf[i] == ref[k][read[k] + i]); i++);
+			if(i < piece) {
+				sprintf(row[0].failure, "case %d, substream %llu word %llu: diverges at generation %d",
+					c, (unsigned long long)substream[k], (unsigned long long)(read[k] + i),
+					CTR_WARMUP + 1 + __builtin_clzll(buf[i] ^ ref[k][read[k] + i]));
+				break;
+			}
+			read[k] += piece;
+			row[0].generations += piece*(CTR_WARMUP + 64)/CTR_WORDS;
+			if(!rewound[k] && (read[k] >= SHM_WORDS/2)) {
+				rule30_shm_detach(&client[k]);
+				if(rule30_shm_attach(&client[k], path, substream[k])) {
+					sprintf(row[0].failure, "case %d: client %d couldn't reattach", c, k);
+					break;
+				}
+				read[k] = 0;
+				rewound[k] = 1;
+			}
+			else if(read[k] == SHM_WORDS)
+				left--;
+		}
+
+		for(k = 0; k < clients; k++)
+			rule30_shm_detach(&client[k]);
+		atomic_store_explicit(&shm->running, 0, memory_order_relaxed);
+		pthread_join(thread, NULL);
+		munmap(shm, size);
+		shm_unlink(path);
+		row[0].cases++;
+
+	}
+
+	return(row_report("shm", row, 1));
+
+}
+
+/* the counter mode at random positions - word w of a block is the harvest of register w	*/
+/* over the 64 generations after the warm-up						*/
+int check_ctr(int cases, int max_gens) {
+
+	struct row row[1];
+	const char *name[1] = { "scalar" };
+	struct rule30_ctr_key key;
+	unsigned long int reg[CTR_REGS];
+	static uint64_t buf[MAX_GENS/64 + CTR_WORDS], ref[MAX_GENS/64 + 2*CTR_WORDS];
+	uint64_t first, block, last;
+	size_t words, i;
+	int c, g, r;
+
+	row_init(row, 1, name);
+	for(c = 0; c < cases && !row[0].failure[0]; c++) {
+
+		rule30_ctr_init(&key, case_random());
+		first = (c % 2) ? case_random() >> 8 : case_random() % 64;
+		words = 1 + case_random() % (max_gens/64);
+
+		last = (first + words - 1) / CTR_WORDS;
+		for(block = first / CTR_WORDS; block <= last; block++) {
+			for(r = 0; r < CTR_REGS; r++) {
+				reg[r] = key.reg[r] ^ (block*rule30_ctr_spread[r]);
+				ref[(block - first / CTR_WORDS)*CTR_WORDS + r] = 0;
+			}
+			for(g = 0; g < CTR_WARMUP; g++)
+				reference_generation(reg, CTR_REGS, RULE30);
+			for(g = 0; g < 64; g++) {
+				reference_generation(reg, CTR_REGS, RULE30);
+				for(r = 0; r < CTR_REGS; r++)
+					ref[(block - first / CTR_WORDS)*CTR_WORDS + r] = (ref[(block - first / CTR_WORDS)*CTR_WORDS + r] << 1) | ((reg[r] >> CTR_CENTER) & 1);
+			}
+			row[0].generations += CTR_WARMUP + 64;
+		}
+
+		rule30_ctr_fill_u64(&key, first, buf, words);
+		for(i = 0; i < words; i++) {
+			if(buf[i] != ref[first % CTR_WORDS + i]) {
+				sprintf(row[0].failure, "case %d, block %llu word %llu: diverges at generation %d",
+					c, (unsigned long long)((first + i) / CTR_WORDS), (unsigned long long)((first + i) % CTR_WORDS),
+					CTR_WARMUP + 1 + __builtin_clzll(buf[i] ^ ref[first % CTR_WORDS + i]));
+				break;
+			}
+		}
+		row[0].cases++;
+
+	}
+
+	return(row_report("ctr", row, 1));
+
+}
+
+/* the jump-ahead under each linear rule, from every generation count up to the case's	*/
+/* length, and composed for long jumps						*/
+int check_jump(int cases, int max_gens) {
+
+	static const unsigned long int linear[] = { 60, 90, 102, 150, 170, 204, 240, 0 };
+	struct row row[1];
+	const char *name[1] = { "scalar" };
+	unsigned long int start[MAX_REGS], ref[MAX_REGS], reg[MAX_REGS], rule;
+	uint64_t a, b;
+	int c, g, gens, regs, i;
+
+	row_init(row, 1, name);
+	for(c = 0; c < cases && !row[0].failure[0]; c++) {
+
+		regs = 1 + case_random() % MAX_REGS;
+		rule = linear[case_random() % (sizeof(linear)/sizeof(unsigned long int))];
+		gens = 1 + case_random() % max_gens;
+		for(i = 0; i < regs; i++)
+			start[i] = ref[i] = case_random();
+
+		for(g = 1; g <= gens; g++) {
+			reference_generation(ref, regs, rule);
+			memcpy(reg, start, regs*sizeof(unsigned long int));
+			if(ca_jump(reg, regs, rule, g) || memcmp(reg, ref, regs*sizeof(unsigned long int))) {
+				sprintf(row[0].failure, "case %d, %d cells, rule %lu: diverges at generation %d",
+					c, regs*WORDSIZE, rule, g);
+				break;
+			}
+		}
+
+		/* a + b generations at once and in two jumps */
+		a = case_random() >> 1;
+		b = case_random() >> 1;
+		memcpy(reg, start, regs*sizeof(unsigned long int));
+		memcpy(ref, start, regs*sizeof(unsigned long int));
+		ca_jump(reg, regs, rule, a);
+		ca_jump(reg, regs, rule, b);
+		ca_jump(ref, regs, rule, a + b);
+		if(!row[0].failure[0] && memcmp(reg, ref, regs*sizeof(unsigned long int)))
+			sprintf(row[0].failure, "case %d, %d cells, rule %lu: %llu + %llu generations differ from their sum",
+				c, regs*WORDSIZE, rule, (unsigned long long)a, (unsigned long long)b);
+
+		row[0].cases++;
+		row[0].generations += gens;
+
+	}
+
+	return(row_report("jump", row, 1));
+
+}
+
+/* the cipher in every variant for random keys and plaintexts, against the reference	*/
+/* schedule and Feistel network - the lattice is only visible at the ends, so a failure	*/
+/* names the output word								*/
+int check_xr30256(int cases) {
+
+	struct row row[NUM_ROWS];
+	const char *name[NUM_ROWS];
+	const unsigned long int *order[4];
+	unsigned long int key[4], subkey[4][4], plaintext[4], ciphertext[4], ref[4], in[4], out[4];
+	struct scheduled_key *skey;
+	int count = kernels(name), c, k, i;
+
+	row_init(row, count, name);
+	for(c = 0; c < cases; c++) {
+
+		for(i = 0; i < 4; i++) {
+			key[i] = case_random();
+			plaintext[i] = case_random();
+		}
+
+		reference_key_schedule(key, subkey);
+		for(i = 0; i < 4; i++)
+			order[i] = subkey[i];
+		reference_cipher(order, plaintext, ref);
+
+		memcpy(in, key, sizeof(in));
+		skey = xr30256_key_schedule(in);
+		for(k = 0; k < count; k++) {
+			if(row[k].failure[0])
+				continue;
+			ca_kernel = k;
+			memcpy(in, plaintext, sizeof(in));
+			xr30256_encrypt_dispatch(skey, in, ciphertext);
+			if(memcmp(skey, subkey, sizeof(subkey)))
+				sprintf(row[k].failure, "case %d: subkeys differ", c);
+			else {
+				for(i = 0; (i < 4) && (ciphertext[i] == ref[i]); i++);
+				if(i < 4)
+					sprintf(row[k].failure, "case %d: ciphertext word %d differs", c, i);
+				else {
+					xr30256_decrypt_dispatch(skey, ciphertext, out);
+					if(memcmp(out, plaintext, sizeof(out)))
+						sprintf(row[k].failure, "case %d: decryption differs", c);
+				}
+			}
+			row[k].cases++;
+			row[k].generations += 4*CA256 + 2*ROUNDS*4*CA256;
+		}
+		free(skey);
+
+	}
+
+	ca_kernel = ca_kernel_best();
+	return(row_report("xr30256", row, count));
+
+}
+
+void usage(char *progname) {
+
+	fprintf(stderr, "usage: %s [-n cases] [-g generations] [-s seed]\n", progname);
+	fprintf(stderr, "\t-n\trandom cases per check (default %d)\n", NUM_CASES);
+	fprintf(stderr, "\t-g\tlongest stream per case, 64 to %d generations\n", MAX_GENS);
+	exit(1);
+
+}
+
+int main(int argc, char **argv) {
+
+	int c, cases = NUM_CASES, max_gens = MAX_GENS, failed = 0;
+	unsigned long int seed = 1234523;
+
+	while((c = getopt(argc, argv, "n:g:s:")) != -1) {
+		switch(c) {
+			case 'n':
+				cases = atoi(optarg);
+				break;
+			case 'g':
+				max_gens = atoi(optarg);
+				break;
+			case 's':
+				seed = strtoul(optarg, NULL, 0);
+				break;
+			default:
+				usage((char *)argv[0]);
+		}
+	}
+	if((cases < 1) || (max_gens < 64) || (max_gens > MAX_GENS) || (optind != argc)) usage((char *)argv[0]);
+
+	case_state = seed;
+	printf("# seed %lu, %d cases per check, up to %d generations, %s is the best kernel\n", seed, cases, max_gens, ca_kernel_names[ca_kernel_best()]);
+	printf("# %-10s %-8s %8s %12s  %s\n", "check", "kernel", "cases", "generations", "result");
+
+	failed += check_kat();
+	failed += check_lattice(cases, max_gens);
+	failed += check_step(cases, max_gens);
+	failed += check_domain(cases, max_gens);
+	failed += check_center(cases, max_gens);
+	failed += check_taps(cases, max_gens);
+	failed += check_dist(cases);
+	failed += check_bits(cases);
+	failed += check_pool(cases);
+	failed += check_index(cases, max_gens);
+	failed += check_shm((cases + 9)/10);
+	failed += check_ctr(cases, max_gens);
+	failed += check_jump(cases, max_gens);
+	failed += check_xr30256((cases + 9)/10);
+
+	if(failed)
+		printf("# %d kernels FAILED\n", failed);
+	else
+		printf("# every kernel agrees with the reference\n");
+
+	exit(failed ? 1 : 0);
+
+}